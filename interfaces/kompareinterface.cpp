@@ -74,3 +74,12 @@ void KompareInterface::setEncoding(const QString& encoding)
     m_encoding = encoding;
 }
 
+bool KompareInterface::appendDiff(const QString& diffOutput)
+{
+    return openDiff(diffOutput);
+}
+
+bool KompareInterface::openDiffInBackground(const QUrl& diffUrl)
+{
+    return openDiff(diffUrl);
+}
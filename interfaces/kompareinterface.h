@@ -43,12 +43,13 @@ protected:
 
 public:
     /**
-     * Open and parse the diff file at url.
+     * Open and parse the diff file at url, this returns once it is shown
+     * or could not be opened.
      */
     virtual bool openDiff(const QUrl& diffUrl) = 0;
 
     /**
-     * Open and parse the supplied diff output
+     * Open and parse the supplied diff output, this returns once it is parsed
      */
     virtual bool openDiff(const QString& diffOutput) = 0;
 
@@ -124,6 +125,23 @@ public:
      */
     virtual bool queryClose() = 0;
 
+public:
+    /**
+     * Add the files of the supplied diff output to the diff that is shown,
+     * the files that are there are not parsed again. Without a diff to add
+     * to this is the same as openDiff(const QString&).
+     */
+    virtual bool appendDiff(const QString& diffOutput);
+
+    /**
+     * Open and parse the diff file at url in the background, this returns
+     * before it is shown. True means it is being loaded, false that it could
+     * not be opened. The part emits diffOpened(bool) once it is shown or has
+     * failed, also when the loading is stopped. The default implementation
+     * opens the diff with openDiff(const QUrl&).
+     */
+    virtual bool openDiffInBackground(const QUrl& diffUrl);
+
 protected:
     // Add all variables to the KompareInterfacePrivate class and access them through the kip pointer
     KompareInterfacePrivate* kip;
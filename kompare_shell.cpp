@@ -17,7 +17,6 @@
 ***************************************************************************/
 #include "kompare_shell.h"
 
-#include <QTextStream>
 #include <QDockWidget>
 #include <QEventLoopLocker>
 #include <QFileDialog>
@@ -42,6 +41,7 @@
 #include <KConfigGroup>
 
 #include "kompareinterface.h"
+#include "komparestdinreader.h"
 #include "kompareurldialog.h"
 
 #define ID_N_OF_N_DIFFERENCES      0
@@ -52,7 +52,9 @@ KompareShell::KompareShell()
     : KParts::MainWindow(),
       m_textViewPart(nullptr),
       m_textViewWidget(nullptr),
-      m_eventLoopLocker(new QEventLoopLocker())
+      m_eventLoopLocker(new QEventLoopLocker()),
+      m_stdinReader(nullptr),
+      m_stdinShown(false)
 {
     resize(800, 480);
 
@@ -138,6 +140,8 @@ KompareShell::KompareShell()
 
     connect(m_viewPart, SIGNAL(diffString(QString)),
             this, SLOT(slotSetDiffString(QString)));
+    connect(m_viewPart, SIGNAL(diffOpened(bool)),
+            this, SLOT(slotDiffOpened(bool)));
 
     // Read basic main-view settings, and set to autosave
     setAutoSaveSettings(QStringLiteral("General Options"));
@@ -162,27 +166,51 @@ bool KompareShell::queryClose()
 void KompareShell::openDiff(const QUrl& url)
 {
     qCDebug(KOMPARESHELL) << "Url = " << url.toDisplayString();
+    stopStdin();
     m_diffURL = url;
-    viewPart()->openDiff(url);
+    viewPart()->openDiffInBackground(url);
 }
 
 void KompareShell::openStdin()
 {
     qCDebug(KOMPARESHELL) << "Using stdin to read the diff" ;
-    QFile file;
-    file.open(stdin, QIODevice::ReadOnly);
-    QTextStream stream(&file);
-
-    QString diff = stream.readAll();
-
-    file.close();
+    stopStdin();
+
+    // The files are shown as they come in, the producer may take a while
+    m_stdinReader = new KompareStdinReader(this);
+    m_stdinShown = false;
+    connect(m_stdinReader, &KompareStdinReader::diffAvailable,
+            this, &KompareShell::slotStdinRead);
+    connect(m_stdinReader, &KompareStdinReader::finished,
+            this, &KompareShell::slotStdinRead);
+    connect(m_stdinReader, &KompareStdinReader::finished,
+            this, &KompareShell::stopStdin);
+    m_stdinReader->start();
+}
 
-    viewPart()->openDiff(diff);
+void KompareShell::slotStdinRead(const QString& diff)
+{
+    // the first sections replace the diff that is shown, the others are added to them
+    if (!m_stdinShown)
+        viewPart()->openDiff(diff);
+    else if (!diff.isEmpty())
+        viewPart()->appendDiff(diff);
+    m_stdinShown = true;
+}
 
+void KompareShell::stopStdin()
+{
+    if (m_stdinReader)
+    {
+        m_stdinReader->disconnect(this);
+        m_stdinReader->deleteLater();
+        m_stdinReader = nullptr;
+    }
 }
 
 void KompareShell::compare(const QUrl& source, const QUrl& destination)
 {
+    stopStdin();
     m_sourceURL = source;
     m_destinationURL = destination;
 
@@ -191,6 +219,7 @@ void KompareShell::compare(const QUrl& source, const QUrl& destination)
 
 void KompareShell::blend(const QUrl& url1, const QUrl& diff)
 {
+    stopStdin();
     m_sourceURL = url1;
     m_destinationURL = diff;
 
@@ -442,6 +471,16 @@ void KompareShell::slotSetDiffString(const QString& diffString)
     m_diffString = diffString;
 }
 
+void KompareShell::slotDiffOpened(bool success)
+{
+    // the part opens the diff in the background, a session must not restore one that failed
+    if (!success)
+    {
+        qCDebug(KOMPARESHELL) << "Could not open " << m_diffURL.toDisplayString();
+        m_diffURL = QUrl();
+    }
+}
+
 void KompareShell::optionsConfigureKeys()
 {
     KShortcutsDialog dlg(KShortcutsEditor::AllActions, KShortcutsEditor::LetterShortcutsAllowed, this);
@@ -35,6 +35,7 @@ class KToggleAction;
 class KSqueezedTextLabel;
 class KomparePart;
 class KompareNavTreePart;
+class KompareStdinReader;
 class QLabel;
 class QEventLoopLocker;
 
@@ -120,13 +121,16 @@ private Q_SLOTS:
     void optionsConfigureKeys();
     void optionsConfigureToolbars();
     void slotSetDiffString(const QString& diffString);
+    void slotDiffOpened(bool success);
     void newToolbarConfig();
     void slotVisibilityChanged(bool visible);
+    void slotStdinRead(const QString& diff);
 
 private:
     void setupAccel();
     void setupActions();
     void setupStatusBar();
+    void stopStdin();
 
 private:
     QUrl                        m_sourceURL;
@@ -152,6 +156,8 @@ private:
     QLabel*                     m_filesLabel;
     QLabel*                     m_differencesLabel;
     QEventLoopLocker*           m_eventLoopLocker;
+    KompareStdinReader*         m_stdinReader;
+    bool                        m_stdinShown;
 };
 
 #endif // KOMPARE_H
@@ -110,6 +110,10 @@ void KompareNavTreePart::slotModelsChanged(const DiffModelList* modelList)
 {
     qCDebug(KOMPARENAVVIEW) << "Models (" << modelList << ") have changed... scanning the models... " ;
 
+    // the items that showed the selection are gone, it is set again
+    m_selectedModel = nullptr;
+    m_selectedDifference = nullptr;
+
     if (modelList)
     {
         m_modelList = modelList;
@@ -430,10 +434,14 @@ void KompareNavTreePart::slotApplyAllDifferences(bool /*apply*/)
 
     qCDebug(KOMPARENAVVIEW) << "m_diffToChangeItemDict.count() = " << m_diffToChangeItemDict.count() ;
 
+    // Relabel all changes first and repaint the list once. The labels are not
+    // in the sort column, so the list does not need to be resorted.
+    m_changesList->setUpdatesEnabled(false);
     for (; it != end ; ++it)
     {
         it.value()->setDifferenceText();
     }
+    m_changesList->setUpdatesEnabled(true);
 }
 
 void KompareNavTreePart::slotApplyDifference(const Difference* diff, bool /*apply*/)
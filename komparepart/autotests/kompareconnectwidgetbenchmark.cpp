@@ -0,0 +1,93 @@
+/***************************************************************************
+                                kompareconnectwidgetbenchmark.cpp
+                                ---------------------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include <QPixmap>
+#include <QTest>
+
+#include <libkomparediff2/diffsettings.h>
+#include <libkomparediff2/komparemodellist.h>
+
+#include "kompareconnectwidget.h"
+#include "komparelistview.h"
+#include "komparesplitter.h"
+#include "viewsettings.h"
+
+using namespace Diff2;
+
+/**
+ * Measures how long the connect widget takes to paint all of its
+ * connectors, against the number of differences that are visible.
+ */
+class KompareConnectWidgetBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void paint_data();
+    void paint();
+};
+
+// A context line between every changed line keeps the differences apart
+static QString makeDiff(int differences)
+{
+    QString diff = QStringLiteral("--- a\n+++ b\n@@ -1,%1 +1,%1 @@\n").arg(2 * differences);
+    for (int i = 0; i < differences; ++i)
+        diff += QStringLiteral(" context %1\n-old %1\n+new line %1\n").arg(i);
+    return diff;
+}
+
+void KompareConnectWidgetBenchmark::paint_data()
+{
+    QTest::addColumn<int>("differences");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+    QTest::newRow("500") << 500;
+}
+
+void KompareConnectWidgetBenchmark::paint()
+{
+    QFETCH(int, differences);
+
+    ViewSettings viewSettings(nullptr);
+    DiffSettings diffSettings(nullptr);
+    KompareSplitter splitter(&viewSettings, nullptr);
+    KompareModelList modelList(&diffSettings, &splitter, nullptr, "modellist", false);
+    connect(&modelList, &KompareModelList::modelsChanged,
+            &splitter, &KompareSplitter::slotModelsChanged);
+    connect(&modelList, static_cast<void(KompareModelList::*)(const DiffModel*, const Difference*)>(&KompareModelList::setSelection),
+            &splitter, static_cast<void(KompareSplitter::*)(const DiffModel*, const Difference*)>(&KompareSplitter::slotSetSelection));
+
+    QCOMPARE(modelList.parseAndOpenDiff(makeDiff(differences)), 0);
+
+    // tall enough for every difference to be visible
+    splitter.resize(600, 2 * differences * splitter.fontMetrics().lineSpacing() + 200);
+    splitter.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&splitter));
+
+    KompareListView* view = static_cast<KompareListViewFrame*>(splitter.widget(0))->view();
+    QCOMPARE(view->lastVisibleDifference() - view->firstVisibleDifference() + 1, differences);
+
+    KompareConnectWidget* widget = static_cast<KompareConnectWidgetFrame*>(splitter.handle(1))->wid();
+    QPixmap pixmap(widget->size());
+    QBENCHMARK {
+        widget->render(&pixmap);
+    }
+}
+
+QTEST_MAIN(KompareConnectWidgetBenchmark)
+
+#include "kompareconnectwidgetbenchmark.moc"
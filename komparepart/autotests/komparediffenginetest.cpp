@@ -0,0 +1,226 @@
+/***************************************************************************
+                                komparediffenginetest.cpp
+                                -------------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include <QFutureInterface>
+#include <QTemporaryFile>
+#include <QTest>
+
+#include <libkomparediff2/diffsettings.h>
+
+#include "komparediffengine.h"
+
+/**
+ * Compares the output of the built-in diff with that of GNU diff.
+ *
+ * The expected hunks were written by GNU diff 3.8 with the options in the
+ * comment above each row. The file headers hold names and times, only
+ * their beginning is checked.
+ */
+class KompareDiffEngineTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Option {
+        IgnoreCase          = 1,
+        IgnoreWhiteSpace    = 2,
+        IgnoreAllWhiteSpace = 4,
+        IgnoreTabExpansion  = 8,
+        IgnoreEmptyLines    = 16,
+        ConvertTabs         = 32
+    };
+
+private Q_SLOTS:
+    void diff_data();
+    void diff();
+};
+
+void KompareDiffEngineTest::diff_data()
+{
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<QString>("destination");
+    QTest::addColumn<int>("options");
+    QTest::addColumn<int>("linesOfContext");
+    QTest::addColumn<QString>("ignoreRegExp");
+    QTest::addColumn<QString>("expected");
+
+    // diff -U3
+    QTest::newRow("hunk header") << QStringLiteral("one\ntwo\nthree\n")
+        << QStringLiteral("one\n2\nthree\n")
+        << 0 << 3 << QString()
+        << QStringLiteral("@@ -1,3 +1,3 @@\n one\n-two\n+2\n three\n");
+    // diff -U3
+    QTest::newRow("merged hunks") << QStringLiteral("line 1\nline 2\nline 3\nline 4\nline 5\nline 6\nline 7\nline 8\nline 9\nline 10\nline 11\nline 12\n")
+        << QStringLiteral("line 1\nchanged 2\nline 3\nline 4\nline 5\nline 6\nline 7\nline 8\nchanged 9\nline 10\nline 11\nline 12\n")
+        << 0 << 3 << QString()
+        << QStringLiteral("@@ -1,12 +1,12 @@\n line 1\n-line 2\n+changed 2\n line 3\n line 4\n line 5\n line 6\n line 7\n line 8\n-line 9\n+changed 9\n line 10\n line 11\n line 12\n");
+    // diff -U3
+    QTest::newRow("context merging boundary") << QStringLiteral("line 1\nline 2\nline 3\nline 4\nline 5\nline 6\nline 7\nline 8\nline 9\nline 10\nline 11\nline 12\n")
+        << QStringLiteral("line 1\nchanged 2\nline 3\nline 4\nline 5\nline 6\nline 7\nline 8\nline 9\nchanged 10\nline 11\nline 12\n")
+        << 0 << 3 << QString()
+        << QStringLiteral("@@ -1,5 +1,5 @@\n line 1\n-line 2\n+changed 2\n line 3\n line 4\n line 5\n@@ -7,6 +7,6 @@\n line 7\n line 8\n line 9\n-line 10\n+changed 10\n line 11\n line 12\n");
+    // diff -U1
+    QTest::newRow("context 1") << QStringLiteral("line 1\nline 2\nline 3\nline 4\nline 5\nline 6\nline 7\nline 8\nline 9\nline 10\nline 11\nline 12\n")
+        << QStringLiteral("line 1\nchanged 2\nline 3\nline 4\nline 5\nchanged 6\nline 7\nline 8\nline 9\nline 10\nline 11\nline 12\n")
+        << 0 << 1 << QString()
+        << QStringLiteral("@@ -1,3 +1,3 @@\n line 1\n-line 2\n+changed 2\n line 3\n@@ -5,3 +5,3 @@\n line 5\n-line 6\n+changed 6\n line 7\n");
+    // diff -U3
+    QTest::newRow("insert and delete") << QStringLiteral("line 1\nline 2\nline 3\nline 4\nline 5\nline 6\nline 7\nline 8\nline 9\nline 10\nline 11\nline 12\n")
+        << QStringLiteral("line 1\nline 3\nline 4\nline 5\nline 6\nline 7\nline 8\nline 9\nline 10\nnew a\nnew b\nline 11\nline 12\n")
+        << 0 << 3 << QString()
+        << QStringLiteral("@@ -1,5 +1,4 @@\n line 1\n-line 2\n line 3\n line 4\n line 5\n@@ -8,5 +7,7 @@\n line 8\n line 9\n line 10\n+new a\n+new b\n line 11\n line 12\n");
+    // diff -U3 -b
+    QTest::newRow("ignore space change") << QStringLiteral("a b\n  c\nd\t\te  \nf\n")
+        << QStringLiteral("a  b\n c\nd e\ng\n")
+        << int(IgnoreWhiteSpace) << 3 << QString()
+        << QStringLiteral("@@ -1,4 +1,4 @@\n a b\n   c\n d\t\te  \n-f\n+g\n");
+    // diff -U3 -b
+    QTest::newRow("ignore space change leading") << QStringLiteral("x\nab\ny\n")
+        << QStringLiteral("x\n ab\ny\n")
+        << int(IgnoreWhiteSpace) << 3 << QString()
+        << QStringLiteral("@@ -1,3 +1,3 @@\n x\n-ab\n+ ab\n y\n");
+    // diff -U3 -w
+    QTest::newRow("ignore all space") << QStringLiteral("a b\n  c\nd\t\te  \nf\n")
+        << QStringLiteral("ab\nc\nd e\ng\n")
+        << int(IgnoreAllWhiteSpace) << 3 << QString()
+        << QStringLiteral("@@ -1,4 +1,4 @@\n a b\n   c\n d\t\te  \n-f\n+g\n");
+    // diff -U3 -i
+    QTest::newRow("ignore case") << QStringLiteral("Hello\nWorld\nfoo\n")
+        << QStringLiteral("hello\nWORLD\nbar\n")
+        << int(IgnoreCase) << 3 << QString()
+        << QStringLiteral("@@ -1,3 +1,3 @@\n Hello\n World\n-foo\n+bar\n");
+    // diff -U3 -B
+    QTest::newRow("ignore blank lines") << QStringLiteral("a\nb\nc\nd\ne\nf\ng\nh\ni\nj\n")
+        << QStringLiteral("a\nb\n\nc\nd\ne\nf\ng\nh\nI\nj\n")
+        << int(IgnoreEmptyLines) << 3 << QString()
+        << QStringLiteral("@@ -1,10 +1,11 @@\n a\n b\n+\n c\n d\n e\n f\n g\n h\n-i\n+I\n j\n");
+    // diff -U3 -B
+    QTest::newRow("ignore blank lines only") << QStringLiteral("a\nb\nc\n")
+        << QStringLiteral("a\n\nb\nc\n\n")
+        << int(IgnoreEmptyLines) << 3 << QString()
+        << QString();
+    // diff -U3 -I ^#
+    QTest::newRow("ignore matching lines") << QStringLiteral("a\n# one\nb\nc\nd\ne\nf\ng\nh\n")
+        << QStringLiteral("a\n# two\nb\nc\nd\ne\nf\ng\nH\n")
+        << 0 << 3 << QStringLiteral("^#")
+        << QStringLiteral("@@ -1,9 +1,9 @@\n a\n-# one\n+# two\n b\n c\n d\n e\n f\n g\n-h\n+H\n");
+    // diff -U3 -E
+    QTest::newRow("ignore tab expansion") << QStringLiteral("a\tb\nc\n")
+        << QStringLiteral("a       b\nd\n")
+        << int(IgnoreTabExpansion) << 3 << QString()
+        << QStringLiteral("@@ -1,2 +1,2 @@\n a\tb\n-c\n+d\n");
+    // diff -U3
+    QTest::newRow("missing newline source") << QStringLiteral("a\nb\nc")
+        << QStringLiteral("a\nb\nc\n")
+        << 0 << 3 << QString()
+        << QStringLiteral("@@ -1,3 +1,3 @@\n a\n b\n-c\n\\ No newline at end of file\n+c\n");
+    // diff -U3
+    QTest::newRow("missing newline destination") << QStringLiteral("a\nb\nc\n")
+        << QStringLiteral("a\nb\nd")
+        << 0 << 3 << QString()
+        << QStringLiteral("@@ -1,3 +1,3 @@\n a\n b\n-c\n+d\n\\ No newline at end of file\n");
+    // diff -U3
+    QTest::newRow("missing newline both") << QStringLiteral("a\nb\nc")
+        << QStringLiteral("a\nB\nc")
+        << 0 << 3 << QString()
+        << QStringLiteral("@@ -1,3 +1,3 @@\n a\n-b\n+B\n c\n\\ No newline at end of file\n");
+    // diff -U3
+    QTest::newRow("empty source") << QString()
+        << QStringLiteral("a\nb\n")
+        << 0 << 3 << QString()
+        << QStringLiteral("@@ -0,0 +1,2 @@\n+a\n+b\n");
+    // diff -U3
+    QTest::newRow("empty destination") << QStringLiteral("a\n")
+        << QString()
+        << 0 << 3 << QString()
+        << QStringLiteral("@@ -1 +0,0 @@\n-a\n");
+    // diff -U3
+    QTest::newRow("both empty") << QString()
+        << QString()
+        << 0 << 3 << QString()
+        << QString();
+    // diff -U3
+    QTest::newRow("identical") << QStringLiteral("line 1\nline 2\nline 3\nline 4\nline 5\nline 6\nline 7\nline 8\nline 9\nline 10\nline 11\nline 12\n")
+        << QStringLiteral("line 1\nline 2\nline 3\nline 4\nline 5\nline 6\nline 7\nline 8\nline 9\nline 10\nline 11\nline 12\n")
+        << 0 << 3 << QString()
+        << QString();
+    // diff -U3 -i -b
+    QTest::newRow("identical after ignoring") << QStringLiteral("A  b\n")
+        << QStringLiteral("a b\n")
+        << int(IgnoreCase | IgnoreWhiteSpace) << 3 << QString()
+        << QString();
+    // diff -U3 -t
+    QTest::newRow("convert tabs") << QStringLiteral("x\n\ta\ny\n")
+        << QStringLiteral("x\n\tb\ny\n")
+        << int(ConvertTabs) << 3 << QString()
+        << QStringLiteral("@@ -1,3 +1,3 @@\n x\n-        a\n+        b\n y\n");
+}
+
+static bool writeFile(QTemporaryFile& file, const QString& text)
+{
+    if (!file.open())
+        return false;
+    file.write(text.toUtf8());
+    file.close();
+    return true;
+}
+
+void KompareDiffEngineTest::diff()
+{
+    QFETCH(QString, source);
+    QFETCH(QString, destination);
+    QFETCH(int, options);
+    QFETCH(int, linesOfContext);
+    QFETCH(QString, ignoreRegExp);
+    QFETCH(QString, expected);
+
+    QTemporaryFile sourceFile, destinationFile;
+    QVERIFY(writeFile(sourceFile, source));
+    QVERIFY(writeFile(destinationFile, destination));
+
+    DiffSettings settings(nullptr);
+    settings.m_linesOfContext = linesOfContext;
+    settings.m_ignoreChangesInCase = options & IgnoreCase;
+    settings.m_ignoreWhiteSpace = options & IgnoreWhiteSpace;
+    settings.m_ignoreAllWhiteSpace = options & IgnoreAllWhiteSpace;
+    settings.m_ignoreChangesDueToTabExpansion = options & IgnoreTabExpansion;
+    settings.m_ignoreEmptyLines = options & IgnoreEmptyLines;
+    settings.m_ignoreRegExp = !ignoreRegExp.isEmpty();
+    settings.m_ignoreRegExpText = ignoreRegExp;
+    settings.m_convertTabsToSpaces = options & ConvertTabs;
+    settings.m_createSmallerDiff = true;
+
+    QFutureInterface<KompareDiffResult> future;
+    const KompareDiffResult result = KompareDiffEngine(&settings).diff(sourceFile.fileName(), destinationFile.fileName(),
+                                                                       QStringLiteral("UTF-8"), future);
+    QVERIFY(result.errorString.isEmpty());
+
+    if (expected.isEmpty())
+    {
+        QVERIFY(result.diff.isEmpty());
+        return;
+    }
+
+    const QStringList lines = result.diff.split(QLatin1Char('\n'));
+    QVERIFY(lines.size() > 2);
+    QVERIFY(lines.at(0).startsWith(QLatin1String("--- ") + sourceFile.fileName() + QLatin1Char('\t')));
+    QVERIFY(lines.at(1).startsWith(QLatin1String("+++ ") + destinationFile.fileName() + QLatin1Char('\t')));
+    QCOMPARE(lines.mid(2).join(QLatin1Char('\n')), expected);
+}
+
+QTEST_GUILESS_MAIN(KompareDiffEngineTest)
+
+#include "komparediffenginetest.moc"
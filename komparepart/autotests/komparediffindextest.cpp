@@ -0,0 +1,107 @@
+/***************************************************************************
+                                komparediffindextest.cpp
+                                ------------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include <QTemporaryFile>
+#include <QTest>
+#include <QTextCodec>
+
+#include "komparediffindex.h"
+
+/**
+ * Checks that a diff is split into pages and chunks at its file headers
+ * only, never at lines of a hunk that look like one.
+ */
+class KompareDiffIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void pages_data();
+    void pages();
+    void chunks();
+};
+
+void KompareDiffIndexTest::pages_data()
+{
+    QTest::addColumn<QStringList>("sections");
+
+    // the range lines of a hunk that only inserts follow each other like a header
+    QTest::newRow("context insertion") << QStringList {
+        QStringLiteral("*** a\t2026-10-17\n--- a\t2026-10-17\n***************\n*** 1,2 ****\n  one\n! two\n--- 1,2 ----\n  one\n! zwei\n"),
+        QStringLiteral("*** b\t2026-10-17\n--- b\t2026-10-17\n***************\n*** 5 ****\n--- 6,7 ----\n+ inserted\n+ lines\n"),
+        QStringLiteral("*** c\t2026-10-17\n--- c\t2026-10-17\n***************\n*** 3 ****\n- removed\n--- 2 ----\n"),
+    };
+    // a removed "-- x" and an added "++ y" line
+    QTest::newRow("unified header lines") << QStringList {
+        QStringLiteral("--- a\n+++ a\n@@ -1,2 +1,2 @@\n--- x\n+++ y\n keep\n"),
+        QStringLiteral("--- b\n+++ b\n@@ -1 +1 @@\n-old\n+new\n"),
+    };
+    QTest::newRow("git") << QStringList {
+        QStringLiteral("diff --git a/a b/a\nindex 1..2 100644\n--- a/a\n+++ b/a\n@@ -1 +1,2 @@\n-diff --git x\n+diff --git y\n+Index: z\n"),
+        QStringLiteral("diff --git a/b b/b\n--- a/b\n+++ b/b\n@@ -1 +1 @@\n-1\n+2\n"),
+    };
+}
+
+void KompareDiffIndexTest::pages()
+{
+    QFETCH(QStringList, sections);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(sections.join(QString()).toUtf8());
+    file.close();
+
+    // every file on a page of its own, a header in the wrong place shows as a page too many
+    KompareDiffIndex index;
+    index.setPageSize(1);
+    QVERIFY(index.open(file.fileName()));
+    QCOMPARE(index.fileCount(), sections.size());
+    QCOMPARE(index.pageCount(), sections.size());
+
+    QTextCodec* codec = QTextCodec::codecForName("UTF-8");
+    for (int page = 0; page < sections.size(); ++page)
+        QCOMPARE(index.chunks(page, codec, 1), QStringList(sections.at(page)));
+}
+
+void KompareDiffIndexTest::chunks()
+{
+    const QStringList sections {
+        QStringLiteral("--- a\n+++ a\n@@ -1 +1 @@\n-1\n+2\n"),
+        QStringLiteral("--- b\n+++ b\n@@ -1 +1 @@\n-1\n+2\n"),
+        QStringLiteral("--- c\n+++ c\n@@ -1 +1 @@\n-1\n+2\n"),
+    };
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(sections.join(QString()).toUtf8());
+    file.close();
+
+    KompareDiffIndex index;
+    QVERIFY(index.open(file.fileName()));
+    QCOMPARE(index.pageCount(), 1);
+
+    // a chunk holds whole files, as many as it takes to reach the size
+    QTextCodec* codec = QTextCodec::codecForName("UTF-8");
+    QCOMPARE(index.chunks(0, codec, 1), sections);
+    QCOMPARE(index.chunks(0, codec, sections.at(0).size() + 1),
+             QStringList({ sections.at(0) + sections.at(1), sections.at(2) }));
+    QCOMPARE(index.chunks(0, codec, 1024), QStringList(sections.join(QString())));
+    QVERIFY(index.chunks(1, codec, 1024).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(KompareDiffIndexTest)
+
+#include "komparediffindextest.moc"
@@ -0,0 +1,160 @@
+/***************************************************************************
+                                kompareheightindextest.cpp
+                                --------------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include <QTest>
+
+#include <numeric>
+
+#include "kompareheightindex.h"
+
+/**
+ * Checks the binary indexed tree against plain sums of the heights.
+ */
+class KompareHeightIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void offsets_data();
+    void offsets();
+    void indexAt_data();
+    void indexAt();
+    void setHeight();
+    void empty();
+
+private:
+    static void verify(const KompareHeightIndex& index, const QVector<qint64>& heights);
+};
+
+// the item covering pos the slow way
+static int expectedIndexAt(const QVector<qint64>& heights, qint64 pos)
+{
+    pos = qMax<qint64>(0, pos);
+    qint64 top = 0;
+    for (int i = 0; i < heights.size(); ++i) {
+        top += heights[i];
+        if (pos < top)
+            return i;
+    }
+    return heights.size();
+}
+
+void KompareHeightIndexTest::verify(const KompareHeightIndex& index, const QVector<qint64>& heights)
+{
+    QCOMPARE(index.count(), heights.size());
+
+    qint64 top = 0;
+    for (int i = 0; i < heights.size(); ++i) {
+        QCOMPARE(index.height(i), heights[i]);
+        QCOMPARE(index.offset(i), top);
+        top += heights[i];
+    }
+    QCOMPARE(index.offset(heights.size()), top);
+    QCOMPARE(index.total(), top);
+
+    // every position, one before the first and a few past the end
+    for (qint64 pos = -2; pos < top + 3; ++pos)
+        QCOMPARE(index.indexAt(pos), expectedIndexAt(heights, pos));
+}
+
+void KompareHeightIndexTest::offsets_data()
+{
+    QTest::addColumn<QVector<qint64> >("heights");
+
+    QTest::newRow("one") << QVector<qint64> { 7 };
+    QTest::newRow("power of two") << QVector<qint64> { 1, 2, 3, 4, 5, 6, 7, 8 };
+    QTest::newRow("odd count") << QVector<qint64> { 3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5 };
+    QTest::newRow("zero heights") << QVector<qint64> { 0, 0, 4, 0, 3, 0, 0, 2, 0 };
+    QTest::newRow("all zero") << QVector<qint64> { 0, 0, 0 };
+}
+
+void KompareHeightIndexTest::offsets()
+{
+    QFETCH(QVector<qint64>, heights);
+
+    KompareHeightIndex index;
+    index.reset(heights);
+    verify(index, heights);
+}
+
+void KompareHeightIndexTest::indexAt_data()
+{
+    QTest::addColumn<QVector<qint64> >("heights");
+    QTest::addColumn<qint64>("pos");
+    QTest::addColumn<int>("expected");
+
+    const QVector<qint64> heights { 0, 5, 0, 0, 3, 2, 0 };
+    QTest::newRow("before the first item") << heights << qint64(-1) << 1;
+    QTest::newRow("far before the first item") << heights << qint64(-1000) << 1;
+    QTest::newRow("top of the first item") << heights << qint64(0) << 1;
+    QTest::newRow("bottom of an item") << heights << qint64(4) << 1;
+    QTest::newRow("top after zero heights") << heights << qint64(5) << 4;
+    QTest::newRow("top of the last item") << heights << qint64(8) << 5;
+    QTest::newRow("bottom of the last item") << heights << qint64(9) << 5;
+    QTest::newRow("end") << heights << qint64(10) << heights.size();
+    QTest::newRow("past the end") << heights << qint64(1000) << heights.size();
+    QTest::newRow("first item without zero heights") << QVector<qint64> { 2, 2 } << qint64(-1) << 0;
+}
+
+void KompareHeightIndexTest::indexAt()
+{
+    QFETCH(QVector<qint64>, heights);
+    QFETCH(qint64, pos);
+    QFETCH(int, expected);
+
+    KompareHeightIndex index;
+    index.reset(heights);
+    QCOMPARE(index.indexAt(pos), expected);
+}
+
+void KompareHeightIndexTest::setHeight()
+{
+    QVector<qint64> heights { 4, 0, 2, 7, 1, 0, 3, 3, 5, 1, 2, 8, 0 };
+    KompareHeightIndex index;
+    index.reset(heights);
+
+    // grow, shrink, collapse to zero and reopen, at both ends and in between
+    const QVector<QPair<int, qint64> > changes {
+        { 0, 9 }, { 12, 4 }, { 6, 0 }, { 1, 3 }, { 6, 2 }, { 0, 0 }, { 11, 1 }, { 5, 5 }, { 12, 0 }
+    };
+    for (const QPair<int, qint64>& change : changes) {
+        index.setHeight(change.first, change.second);
+        heights[change.first] = change.second;
+        verify(index, heights);
+    }
+
+    // heights beyond an int
+    index.setHeight(3, qint64(1) << 40);
+    heights[3] = qint64(1) << 40;
+    QCOMPARE(index.total(), std::accumulate(heights.constBegin(), heights.constEnd(), qint64(0)));
+    QCOMPARE(index.offset(4), heights[0] + heights[1] + heights[2] + heights[3]);
+    QCOMPARE(index.indexAt((qint64(1) << 40) + heights[0] + heights[1] + heights[2] - 1), 3);
+}
+
+void KompareHeightIndexTest::empty()
+{
+    KompareHeightIndex index;
+    verify(index, QVector<qint64>());
+
+    index.reset({ 1, 2 });
+    index.clear();
+    verify(index, QVector<qint64>());
+    QCOMPARE(index.indexAt(-1), 0);
+}
+
+QTEST_GUILESS_MAIN(KompareHeightIndexTest)
+
+#include "kompareheightindextest.moc"
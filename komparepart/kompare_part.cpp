@@ -21,6 +21,9 @@
 #include "kompare_part.h"
 
 #include <QDialog>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
 #include <QLayout>
 #include <QWidget>
 #include <QMenu>
@@ -30,43 +33,58 @@
 #include <QPrintPreviewDialog>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
+#include <QTextCodec>
+#include <QTimer>
+#include <QtConcurrent>
 
 #include <KAboutData>
 #include <KActionCollection>
-#include <KJobWidgets>
 #include <KLocalizedString>
 #include <KMessageBox>
+#include <KParts/StatusBarExtension>
 #include <KSharedConfig>
 #include <KStandardAction>
 #include <KStandardShortcut>
 #include <KStandardGuiItem>
 #include <KXMLGUIFactory>
 
-#include <KIO/CopyJob>
-#include <KIO/StatJob>
-#include <KIO/FileCopyJob>
 #include <KIO/MkdirJob>
 
 #include <libkomparediff2/diffmodel.h>
-#include <libkomparediff2/diffsettings.h>
 
 #include <komparepartdebug.h>
 #include "komparelistview.h"
 #include "kompareconnectwidget.h"
+#include "komparediffengine.h"
+#include "komparediffindex.h"
+#include "komparediffsettings.h"
+#include "kompareloadprogress.h"
 #include "viewsettings.h"
 #include "kompareprefdlg.h"
 #include "komparesaveoptionswidget.h"
+#include "komparesearch.h"
+#include "komparesearchdialog.h"
 #include "komparesplitter.h"
+#include "kompareurlfetcher.h"
 #include "kompareview.h"
 
+// The parser gets a diff in chunks of files of about this many bytes
+#define PARSE_CHUNK_SIZE (1024 * 1024)
+
 using namespace Diff2;
 
 ViewSettings* KomparePart::m_viewSettings = nullptr;
-DiffSettings* KomparePart::m_diffSettings = nullptr;
+KompareDiffSettings* KomparePart::m_diffSettings = nullptr;
 
 KomparePart::KomparePart(QWidget* parentWidget, QObject* parent, const KAboutData& aboutData, Modus modus) :
     KParts::ReadWritePart(parent),
-    m_info()
+    m_searchDialog(nullptr),
+    m_info(),
+    m_fetchedAction(nullptr),
+    m_sectionParser(nullptr),
+    m_parsedChunks(0),
+    m_openingDiff(false),
+    m_diffPage(0)
 {
     setComponentData(aboutData);
 
@@ -77,7 +95,7 @@ KomparePart::KomparePart(QWidget* parentWidget, QObject* parent, const KAboutDat
         m_viewSettings = new ViewSettings(nullptr);
     }
     if (!m_diffSettings) {
-        m_diffSettings = new DiffSettings(nullptr);
+        m_diffSettings = new KompareDiffSettings(nullptr);
     }
 
     readProperties(KSharedConfig::openConfig().data());
@@ -144,6 +162,8 @@ KomparePart::KomparePart(QWidget* parentWidget, QObject* parent, const KAboutDat
     connect(this, &KomparePart::kompareInfo, m_modelList, &KompareModelList::slotKompareInfo);
 
     // Here we connect the splitter to the modellist
+    connect(m_modelList, &KompareModelList::modelsChanged,
+            m_splitter, &KompareSplitter::slotModelsChanged);
     connect(m_modelList, static_cast<void_KompareModelList_argModelDiff>(&KompareModelList::setSelection),
             m_splitter,  static_cast<void_KompareSplitter_argModelDiff>(&KompareSplitter::slotSetSelection));
 //     connect(m_splitter,  SIGNAL(selectionChanged(const Diff2::Difference*,const Diff2::Difference*)),
@@ -161,6 +181,26 @@ KomparePart::KomparePart(QWidget* parentWidget, QObject* parent, const KAboutDat
             m_splitter, static_cast<void_KompareSplitter_argDiffBool>(&KompareSplitter::slotApplyDifference));
     connect(this, &KomparePart::configChanged, m_splitter, &KompareSplitter::configChanged);
 
+    // The search keeps an index of the models until they change
+    m_search = new KompareSearch(this);
+    connect(m_modelList, &KompareModelList::modelsChanged,
+            m_search, &KompareSearch::slotModelsChanged);
+
+    // Loading goes through stages, shown and timed in the status bar
+    m_progress = new KompareLoadProgress(m_view);
+    KParts::StatusBarExtension* statusBar = new KParts::StatusBarExtension(this);
+    statusBar->addStatusBarItem(m_progress, 0, true);
+    connect(m_progress, &KompareLoadProgress::cancelRequested,
+            this, &KomparePart::slotStopLoading);
+    connect(&m_diffReader, &QFutureWatcher<KompareDiffPage>::finished,
+            this, &KomparePart::slotDiffRead);
+    connect(&m_diffEngine, &QFutureWatcher<KompareDiffResult>::finished,
+            this, &KomparePart::slotDiffComputed);
+    connect(m_modelList, &KompareModelList::modelsChanged,
+            this, &KomparePart::slotModelsParsed);
+    connect(m_modelList, &KompareModelList::error,
+            m_progress, &KompareLoadProgress::finish);
+
     setupActions(modus);
 
     // we are read-write by default -> uhm what if we are opened by lets say konq in RO mode ?
@@ -173,6 +213,7 @@ KomparePart::KomparePart(QWidget* parentWidget, QObject* parent, const KAboutDat
 
 KomparePart::~KomparePart()
 {
+    cancelLoading();
     // This is the only place allowed to call cleanUpTemporaryFiles
     // because before there might still be a use for them (when swapping)
     cleanUpTemporaryFiles();
@@ -201,6 +242,18 @@ void KomparePart::setupActions(Modus modus)
     m_diffRefresh->setIcon(QIcon::fromTheme(QStringLiteral("view-refresh")));
     m_diffRefresh->setText(i18n("Refresh Diff"));
     actionCollection()->setDefaultShortcuts(m_diffRefresh, KStandardShortcut::reload());
+    m_stopLoading = actionCollection()->addAction(QStringLiteral("file_stop"), this, &KomparePart::slotStopLoading);
+    m_stopLoading->setIcon(QIcon::fromTheme(QStringLiteral("process-stop")));
+    m_stopLoading->setText(i18n("&Stop Loading"));
+    actionCollection()->setDefaultShortcut(m_stopLoading, Qt::Key_Escape);
+    m_previousDiffPage = actionCollection()->addAction(QStringLiteral("file_previous_page"), this, &KomparePart::slotPreviousDiffPage);
+    m_previousDiffPage->setIcon(QIcon::fromTheme(QStringLiteral("go-previous-view-page")));
+    m_previousDiffPage->setText(i18n("P&revious Page of Files"));
+    m_nextDiffPage = actionCollection()->addAction(QStringLiteral("file_next_page"), this, &KomparePart::slotNextDiffPage);
+    m_nextDiffPage->setIcon(QIcon::fromTheme(QStringLiteral("go-next-view-page")));
+    m_nextDiffPage->setText(i18n("N&ext Page of Files"));
+
+    m_find = KStandardAction::find(this, &KomparePart::slotFind, actionCollection());
 
     m_print        = KStandardAction::print(this, &KomparePart::slotFilePrint, actionCollection());
     m_printPreview = KStandardAction::printPreview(this, &KomparePart::slotFilePrintPreview, actionCollection());
@@ -214,6 +267,10 @@ void KomparePart::updateActions()
     if (m_swap) m_swap->setEnabled(m_modelList->mode() == Kompare::ComparingFiles || m_modelList->mode() == Kompare::ComparingDirs);
     m_diffRefresh->setEnabled(m_modelList->mode() == Kompare::ComparingFiles || m_modelList->mode() == Kompare::ComparingDirs);
     m_diffStats->setEnabled(m_modelList->modelCount() > 0);
+    m_stopLoading->setEnabled(isLoading());
+    m_previousDiffPage->setEnabled(!isLoading() && m_diffPage > 0 && diffPageCount() > 0);
+    m_nextDiffPage->setEnabled(!isLoading() && m_diffPage + 1 < diffPageCount());
+    m_find->setEnabled(m_modelList->modelCount() > 0);
     m_print->setEnabled(m_modelList->modelCount() > 0);          // If modellist has models then we have something to print, it's that simple.
     m_printPreview->setEnabled(m_modelList);
 }
@@ -221,44 +278,201 @@ void KomparePart::updateActions()
 void KomparePart::setEncoding(const QString& encoding)
 {
     qCDebug(KOMPAREPART) << "Encoding: " << encoding;
+    m_encoding = encoding;
     m_modelList->setEncoding(encoding);
 }
 
 bool KomparePart::openDiff(const QUrl& url)
+{
+    if (!openDiffInBackground(url))
+        return false;
+
+    // callers rely on the diff being there when this returns
+    bool success = false;
+    QEventLoop loop;
+    connect(this, &KomparePart::diffOpened, &loop, [&loop, &success](bool opened) {
+        success = opened;
+        loop.quit();
+    });
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+    return success;
+}
+
+bool KomparePart::openDiffInBackground(const QUrl& url)
 {
     qCDebug(KOMPAREPART) << "Url = " << url.url();
 
+    cancelLoading();
     m_info.mode = Kompare::ShowingDiff;
     m_info.source = url;
-    bool result = false;
+    m_openingDiff = true;
     fetchURL(url, true);
 
+    // the diff is opened once it is downloaded and read
+    whenFetched(&KomparePart::openFetchedDiff);
+    return isLoading();
+}
+
+void KomparePart::finishOpeningDiff(bool success)
+{
+    if (!m_openingDiff)
+        return;
+
+    m_openingDiff = false;
+    emit diffOpened(success);
+}
+
+static KompareDiffPage readDiffPage(QSharedPointer<KompareDiffIndex> index, int page, const QString& encoding)
+{
+    QTextCodec* codec = encoding.isEmpty() ? nullptr : QTextCodec::codecForName(encoding.toLatin1());
+    KompareDiffPage result;
+    result.index = index;
+    result.page = page;
+    result.chunks = index->chunks(page, codec ? codec : QTextCodec::codecForLocale(), PARSE_CHUNK_SIZE);
+    return result;
+}
+
+static KompareDiffPage readDiffFile(const QString& fileName, const QString& encoding)
+{
+    // the index is handed to the part with the page, it is never read while it is built
+    QSharedPointer<KompareDiffIndex> index(new KompareDiffIndex);
+    if (!index->open(fileName))
+    {
+        KompareDiffPage result;
+        result.page = 0;
+        return result;
+    }
+
+    return readDiffPage(index, 0, encoding);
+}
+
+void KomparePart::openFetchedDiff()
+{
     emit kompareInfo(&m_info);
 
     if (!m_info.localSource.isEmpty())
     {
         qCDebug(KOMPAREPART) << "Download succeeded ";
-        result = m_modelList->openDiff(m_info.localSource);
+        // large diffs take a while to read, the parser gets the text when it is done.
+        // Only the first page of a huge one is read, the others when they are asked for
+        m_progress->begin(KompareLoadProgress::Read, true);
+        m_diffReader.setFuture(QtConcurrent::run(readDiffFile, m_info.localSource, m_encoding));
         updateActions();
-        updateCaption();
-        updateStatus();
     }
     else
     {
         qCDebug(KOMPAREPART) << "Download failed !";
+        m_progress->finish();
+        finishOpeningDiff(false);
     }
+}
 
-    return result;
+void KomparePart::slotDiffRead()
+{
+    if (m_diffReader.isCanceled())
+        return;
+
+    const KompareDiffPage result = m_diffReader.result();
+    if (!result.index)
+    {
+        m_progress->finish();
+        slotShowError(i18n("<qt>Could not read the diff file <b>%1</b>.</qt>", m_info.source.toDisplayString()));
+        finishOpeningDiff(false);
+        updateActions();
+        return;
+    }
+
+    // the page that was shown stays until the new one is read,
+    // the models of the page before are freed by the model list
+    m_diffIndex = result.index;
+    m_diffPage = result.page;
+    // the parser reports an empty file
+    parseLater(result.chunks.isEmpty() ? QStringList(QString()) : result.chunks);
+}
+
+void KomparePart::parseLater(const QStringList& chunks)
+{
+    m_progress->begin(KompareLoadProgress::Parse, true);
+    m_parseChunks = chunks;
+    m_parsedChunks = 0;
+    QTimer::singleShot(0, this, &KomparePart::slotParseDiff);
+    updateActions();
+}
+
+void KomparePart::slotParseDiff()
+{
+    // loading was stopped in the meantime
+    if (m_parseChunks.isEmpty())
+        return;
+
+    const QString chunk = m_parseChunks.takeFirst();
+    bool parsed;
+    if (m_parsedChunks++ == 0)
+    {
+        // the model list reports a diff it can not parse
+        m_search->cancel();
+        parsed = m_modelList->parseAndOpenDiff(chunk) == 0;
+    }
+    else
+    {
+        parsed = appendModels(chunk);
+    }
+
+    // the files that are parsed are shown while the event loop gets to run
+    if (parsed && !m_parseChunks.isEmpty())
+    {
+        QTimer::singleShot(0, this, &KomparePart::slotParseDiff);
+        updateStatus();
+        return;
+    }
+
+    m_parseChunks.clear();
+    m_progress->finish();
+    finishOpeningDiff(parsed);
+    updateActions();
+    updateCaption();
+    updateStatus();
+}
+
+bool KomparePart::appendModels(const QString& diff)
+{
+    // The model list can not add to its models, a list of its own parses
+    // them and hands them over. The models that are there stay as they are,
+    // with the differences that were applied and the caches of the views.
+    if (!m_sectionParser)
+    {
+        m_sectionParser = new Diff2::KompareModelList(m_diffSettings, m_splitter, this, "kompareappendedmodels", false);
+        m_sectionParser->slotKompareInfo(&m_info);
+        connect(m_sectionParser, &KompareModelList::error,
+                this, &KomparePart::slotShowError);
+    }
+
+    if (m_sectionParser->parseAndOpenDiff(diff) != 0)
+        return false;
+
+    DiffModelList* parsed = const_cast<DiffModelList*>(m_sectionParser->models());
+    DiffModelList* models = const_cast<DiffModelList*>(m_modelList->models());
+    models->append(*parsed);
+    parsed->clear();
+
+    // the navigation lists the new files, the model list counts them
+    emit modelsChanged(models);
+    emit selectionChanged(m_modelList->selectedModel(), m_modelList->selectedDifference());
+    return true;
 }
 
 bool KomparePart::openDiff(const QString& diffOutput)
 {
     bool value = false;
 
+    // a diff that is still loading would replace this one when it is done
+    cancelLoading();
     m_info.mode = Kompare::ShowingDiff;
+    m_diffIndex.reset();
 
     emit kompareInfo(&m_info);
 
+    m_progress->begin(KompareLoadProgress::Parse, false);
     if (m_modelList->parseAndOpenDiff(diffOutput) == 0)
     {
         value = true;
@@ -266,10 +480,52 @@ bool KomparePart::openDiff(const QString& diffOutput)
         updateCaption();
         updateStatus();
     }
+    m_progress->finish();
 
     return value;
 }
 
+bool KomparePart::appendDiff(const QString& diffOutput)
+{
+    // the files of a diff that is still loading come with it
+    if (m_info.mode != Kompare::ShowingDiff || m_modelList->modelCount() == 0 || isLoading())
+        return openDiff(diffOutput);
+
+    m_progress->begin(KompareLoadProgress::Parse, false);
+    const bool value = appendModels(diffOutput);
+    m_progress->finish();
+    updateActions();
+    updateCaption();
+    updateStatus();
+
+    return value;
+}
+
+int KomparePart::diffPageCount() const
+{
+    return m_diffIndex && m_info.mode == Kompare::ShowingDiff ? m_diffIndex->pageCount() : 0;
+}
+
+void KomparePart::loadDiffPage(int page)
+{
+    if (isLoading() || page < 0 || page >= diffPageCount())
+        return;
+
+    m_progress->begin(KompareLoadProgress::Read, true);
+    m_diffReader.setFuture(QtConcurrent::run(readDiffPage, m_diffIndex, page, m_encoding));
+    updateActions();
+}
+
+void KomparePart::slotPreviousDiffPage()
+{
+    loadDiffPage(m_diffPage - 1);
+}
+
+void KomparePart::slotNextDiffPage()
+{
+    loadDiffPage(m_diffPage + 1);
+}
+
 bool KomparePart::openDiff3(const QUrl& diff3Url)
 {
     // FIXME: Implement this !!!
@@ -285,100 +541,114 @@ bool KomparePart::openDiff3(const QString& diff3Output)
     return false;
 }
 
-bool KomparePart::fetchURL(const QUrl& url, bool addToSource)
+void KomparePart::fetchURL(const QUrl& url, bool addToSource)
 {
-    // Default value if there is an error is "", we rely on it!
-    QString tempFileName;
-    // Only in case of error do we set result to false, don't forget!!
-    bool result = true;
-    QTemporaryDir* tmpDir = nullptr;
-
     if (!url.isLocalFile())
     {
-        KIO::StatJob* statJob = KIO::stat(url);
-        KJobWidgets::setWindow(statJob, widget());
-        if (statJob->exec())
-        {
-            KIO::UDSEntry node;
-            node = statJob->statResult();
-            if (!node.isDir())
-            {
-                tmpDir = new QTemporaryDir(QDir::tempPath() + QLatin1String("/kompare"));
-                tmpDir->setAutoRemove(true);
-                tempFileName = tmpDir->path() + QLatin1Char('/') + url.fileName();
-                KIO::FileCopyJob* copyJob = KIO::file_copy(url, QUrl::fromLocalFile(tempFileName));
-                KJobWidgets::setWindow(copyJob, widget());
-                if (! copyJob->exec())
-                {
-                    qDebug() << "download error " << copyJob->errorString();
-                    slotShowError(i18n("<qt>The URL <b>%1</b> cannot be downloaded.</qt>", url.toDisplayString()));
-                    tempFileName.clear(); // Not sure if download has already touched this tempFileName when there is an error
-                    result = false;
-                }
-            }
-            else
-            {
-                tmpDir = new QTemporaryDir(QDir::tempPath() + QLatin1String("/kompare"));
-                tmpDir->setAutoRemove(true);   // Yes this is the default but just to make sure
-                KIO::CopyJob* copyJob = KIO::copy(url, QUrl::fromLocalFile(tmpDir->path()));
-                KJobWidgets::setWindow(copyJob, widget());
-                if (! copyJob->exec())
-                {
-                    slotShowError(i18n("<qt>The URL <b>%1</b> cannot be downloaded.</qt>", url.toDisplayString()));
-                    delete tmpDir;
-                    tmpDir = nullptr;
-                    result = false;
-                }
-                else
-                {
-                    tempFileName = tmpDir->path();
-                    qCDebug(KOMPAREPART) << "tempFileName = " << tempFileName;
-                    // If a directory is copied into QTemporaryDir then the directory in
-                    // here is what I need to add to tempFileName
-                    QDir dir(tempFileName);
-                    QStringList entries = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-                    if (entries.size() == 1)   // More than 1 entry in here means big problems!!!
-                    {
-                        if (!tempFileName.endsWith(QLatin1Char('/')))
-                            tempFileName += QLatin1Char('/');
-                        tempFileName += entries.at(0);
-                        tempFileName += QLatin1Char('/');
-                    }
-                    else
-                    {
-                        qCDebug(KOMPAREPART) << "Yikes, nothing downloaded?";
-                        delete tmpDir;
-                        tmpDir = nullptr;
-                        tempFileName.clear();
-                        result = false;
-                    }
-                }
-            }
-        }
+        KompareUrlFetcher* fetcher = new KompareUrlFetcher(url, widget(), this);
+        connect(fetcher, &KompareUrlFetcher::finished, this, &KomparePart::slotURLFetched);
+        m_fetchers.insert(fetcher, addToSource);
+        fetcher->start();
+        updateActions();
+        return;
     }
-    else
-    {
-        // is Local already, check if exists
-        if (QFile::exists(url.toLocalFile())) {
-            tempFileName = url.toLocalFile();
-        } else {
-            slotShowError(i18n("<qt>The URL <b>%1</b> does not exist on your system.</qt>", url.toDisplayString()));
-            result = false;
-        }
+
+    // Default value if there is an error is "", we rely on it!
+    QString fileName;
+    // is Local already, check if exists
+    if (QFile::exists(url.toLocalFile())) {
+        fileName = url.toLocalFile();
+    } else {
+        slotShowError(i18n("<qt>The URL <b>%1</b> does not exist on your system.</qt>", url.toDisplayString()));
     }
+    setFetchedURL(addToSource, fileName, nullptr);
+}
 
+void KomparePart::setFetchedURL(bool addToSource, const QString& localFile, QTemporaryDir* tmpDir)
+{
     if (addToSource)
     {
-        m_info.localSource = tempFileName;
+        m_info.localSource = localFile;
         m_info.sourceQTempDir = tmpDir;
     }
     else
     {
-        m_info.localDestination = tempFileName;
+        m_info.localDestination = localFile;
         m_info.destinationQTempDir = tmpDir;
     }
+}
+
+void KomparePart::slotURLFetched(KompareUrlFetcher* fetcher)
+{
+    const bool addToSource = m_fetchers.take(fetcher);
+    setFetchedURL(addToSource, fetcher->localPath(), fetcher->takeTemporaryDir());
+    const QString error = fetcher->errorString();
+    fetcher->deleteLater();
+
+    // the other download may finish while the error is shown
+    if (!error.isEmpty())
+        slotShowError(error);
+
+    if (!isFetching() && m_fetchedAction) {
+        FetchedAction action = m_fetchedAction;
+        m_fetchedAction = nullptr;
+        updateActions();
+        (this->*action)();
+    }
+}
 
-    return result;
+void KomparePart::slotModelsParsed()
+{
+    // the views fill themselves from the new models after this,
+    // unless there are more files to parse
+    if (m_progress->stage() == KompareLoadProgress::Parse && m_parseChunks.isEmpty())
+        m_progress->begin(KompareLoadProgress::Present, false);
+}
+
+void KomparePart::whenFetched(FetchedAction action)
+{
+    if (!isFetching()) {
+        (this->*action)();
+        return;
+    }
+
+    m_fetchedAction = action;
+    m_progress->begin(KompareLoadProgress::Fetch, true);
+    QStringList urls;
+    for (KompareUrlFetcher* fetcher : m_fetchers.keys())
+        urls << fetcher->url().toDisplayString();
+    emit setStatusBarText(i18n("Downloading %1...", urls.join(QStringLiteral(", "))));
+}
+
+void KomparePart::cancelLoading()
+{
+    // the search reads the models that are about to be replaced
+    m_search->cancel();
+    if (!isLoading())
+        return;
+
+    for (KompareUrlFetcher* fetcher : m_fetchers.keys()) {
+        fetcher->cancel();
+        fetcher->deleteLater();
+    }
+    m_fetchers.clear();
+    m_fetchedAction = nullptr;
+    // the file is read or compared to the end, the result is dropped
+    m_diffReader.cancel();
+    m_diffEngine.cancel();
+    m_parseChunks.clear();
+    m_progress->finish();
+    finishOpeningDiff(false);
+    updateActions();
+}
+
+void KomparePart::slotStopLoading()
+{
+    if (!isLoading())
+        return;
+
+    cancelLoading();
+    emit setStatusBarText(i18n("Loading stopped"));
 }
 
 void KomparePart::cleanUpTemporaryFiles()
@@ -410,6 +680,7 @@ void KomparePart::compare(const QUrl& source, const QUrl& destination)
     // wait until i am in the modellist to determine the mode we're supposed to be in.
     // That should make the code more readable
     // I should store the QTemporaryDir(s)/File(s) in the Info struct as well and delete it at the right time
+    cancelLoading();
     m_info.source = source;
     m_info.destination = destination;
 
@@ -418,6 +689,11 @@ void KomparePart::compare(const QUrl& source, const QUrl& destination)
     fetchURL(source, true);
     fetchURL(destination, false);
 
+    whenFetched(&KomparePart::compareFetched);
+}
+
+void KomparePart::compareFetched()
+{
     emit kompareInfo(&m_info);
 
     compareAndUpdateAll();
@@ -426,6 +702,7 @@ void KomparePart::compare(const QUrl& source, const QUrl& destination)
 void KomparePart::compareFileString(const QUrl& sourceFile, const QString& destination)
 {
     //Set the modeto specify that the source is a file, and the destination is a string
+    cancelLoading();
     m_info.mode = Kompare::ComparingFileString;
 
     m_info.source = sourceFile;
@@ -433,14 +710,13 @@ void KomparePart::compareFileString(const QUrl& sourceFile, const QString& desti
 
     fetchURL(sourceFile, true);
 
-    emit kompareInfo(&m_info);
-
-    compareAndUpdateAll();
+    whenFetched(&KomparePart::compareFetched);
 }
 
 void KomparePart::compareStringFile(const QString& source, const QUrl& destinationFile)
 {
     //Set the modeto specify that the source is a file, and the destination is a string
+    cancelLoading();
     m_info.mode = Kompare::ComparingStringFile;
 
     m_info.localSource = source;
@@ -448,13 +724,12 @@ void KomparePart::compareStringFile(const QString& source, const QUrl& destinati
 
     fetchURL(destinationFile, false);
 
-    emit kompareInfo(&m_info);
-
-    compareAndUpdateAll();
+    whenFetched(&KomparePart::compareFetched);
 }
 
 void KomparePart::compareFiles(const QUrl& sourceFile, const QUrl& destinationFile)
 {
+    cancelLoading();
     m_info.mode = Kompare::ComparingFiles;
 
     m_info.source = sourceFile;
@@ -465,13 +740,12 @@ void KomparePart::compareFiles(const QUrl& sourceFile, const QUrl& destinationFi
     fetchURL(sourceFile, true);
     fetchURL(destinationFile, false);
 
-    emit kompareInfo(&m_info);
-
-    compareAndUpdateAll();
+    whenFetched(&KomparePart::compareFetched);
 }
 
 void KomparePart::compareDirs(const QUrl& sourceDirectory, const QUrl& destinationDirectory)
 {
+    cancelLoading();
     m_info.mode = Kompare::ComparingDirs;
 
     m_info.source = sourceDirectory;
@@ -480,9 +754,7 @@ void KomparePart::compareDirs(const QUrl& sourceDirectory, const QUrl& destinati
     fetchURL(sourceDirectory, true);
     fetchURL(destinationDirectory, false);
 
-    emit kompareInfo(&m_info);
-
-    compareAndUpdateAll();
+    whenFetched(&KomparePart::compareFetched);
 }
 
 void KomparePart::compare3Files(const QUrl& /*originalFile*/, const QUrl& /*changedFile1*/, const QUrl& /*changedFile2*/)
@@ -495,32 +767,40 @@ void KomparePart::compare3Files(const QUrl& /*originalFile*/, const QUrl& /*chan
 
 void KomparePart::openFileAndDiff(const QUrl& file, const QUrl& diffFile)
 {
+    cancelLoading();
     m_info.source = file;
     m_info.destination = diffFile;
+    m_info.mode = Kompare::BlendingFile;
 
     fetchURL(file, true);
     fetchURL(diffFile, false);
-    m_info.mode = Kompare::BlendingFile;
-
-    emit kompareInfo(&m_info);
 
-    compareAndUpdateAll();
+    whenFetched(&KomparePart::compareFetched);
 }
 
 void KomparePart::openDirAndDiff(const QUrl& dir,  const QUrl& diffFile)
 {
+    cancelLoading();
     m_info.source = dir;
     m_info.destination = diffFile;
+    m_info.mode = Kompare::BlendingDir;
 
     fetchURL(dir, true);
     fetchURL(diffFile, false);
-    m_info.mode = Kompare::BlendingDir;
 
+    whenFetched(&KomparePart::openFetchedDirAndDiff);
+}
+
+void KomparePart::openFetchedDirAndDiff()
+{
     emit kompareInfo(&m_info);
 
     if (!m_info.localSource.isEmpty() && !m_info.localDestination.isEmpty())
     {
-        m_modelList->openDirAndDiff();
+        m_progress->begin(KompareLoadProgress::Diff, false);
+        m_search->cancel();
+        if (!m_modelList->openDirAndDiff())
+            m_progress->finish();
         //Must this be in here? couldn't we use compareAndUpdateAll as well?
         updateActions();
         updateCaption();
@@ -532,8 +812,7 @@ bool KomparePart::openFile()
 {
     // This is called from openURL
     // This is a little inefficient but i will do it anyway
-    openDiff(url());
-    return true;
+    return openDiff(url());
 }
 
 bool KomparePart::saveAll()
@@ -659,12 +938,17 @@ void KomparePart::slotSetStatus(enum Kompare::Status status)
 
     switch (status) {
     case Kompare::RunningDiff:
+    case Kompare::ReRunningDiff:
+        m_progress->begin(KompareLoadProgress::Diff, false);
         emit setStatusBarText(i18n("Running diff..."));
         break;
     case Kompare::Parsing:
+        m_search->cancel();
+        m_progress->begin(KompareLoadProgress::Parse, false);
         emit setStatusBarText(i18n("Parsing diff output..."));
         break;
     case Kompare::FinishedParsing:
+        m_progress->finish();
         updateStatus();
         break;
     case Kompare::FinishedWritingDiff:
@@ -728,7 +1012,14 @@ void KomparePart::updateStatus()
                     destination);
         break;
     case Kompare::ShowingDiff :
-        text = i18n("Viewing diff output from %1", source);
+        if (diffPageCount() > 1)
+            text = i18n("Viewing files %1 to %2 of %3 of diff output from %4",
+                        m_diffIndex->firstFile(m_diffPage) + 1,
+                        m_diffIndex->endFile(m_diffPage),
+                        m_diffIndex->fileCount(),
+                        source);
+        else
+            text = i18n("Viewing diff output from %1", source);
         break;
     case Kompare::BlendingFile :
         text = i18n("Blending diff output from %1 into file %2" ,
@@ -749,30 +1040,88 @@ void KomparePart::updateStatus()
 
 void KomparePart::compareAndUpdateAll()
 {
-    if (!m_info.localSource.isEmpty() && !m_info.localDestination.isEmpty())
+    if (!m_info.localSource.isEmpty() && !m_info.localDestination.isEmpty() && useDiffEngine())
+    {
+        // two files are compared without running diff, its output is parsed when it is done
+        m_info.mode = Kompare::ComparingFiles;
+        m_progress->begin(KompareLoadProgress::Diff, true);
+        m_diffEngine.setFuture(KompareDiffEngine(m_diffSettings).start(m_info.localSource, m_info.localDestination, m_encoding));
+        updateCaption();
+        updateStatus();
+    }
+    else if (!m_info.localSource.isEmpty() && !m_info.localDestination.isEmpty())
     {
+        // diff runs in its own process, the status of the model list moves the progress on
         switch (m_info.mode)
         {
         default:
         case Kompare::UnknownMode:
-            m_modelList->compare();
+            m_progress->begin(KompareLoadProgress::Diff, false);
+            if (!m_modelList->compare())
+                m_progress->finish();
             break;
 
         case Kompare::ComparingStringFile:
         case Kompare::ComparingFileString:
         case Kompare::ComparingFiles:
         case Kompare::ComparingDirs:
-            m_modelList->compare(m_info.mode);
+            m_progress->begin(KompareLoadProgress::Diff, false);
+            if (!m_modelList->compare(m_info.mode))
+                m_progress->finish();
             break;
 
         case Kompare::BlendingFile:
+            m_progress->begin(KompareLoadProgress::Parse, false);
+            m_search->cancel();
             m_modelList->openFileAndDiff();
+            m_progress->finish();
             break;
         }
         updateCaption();
         updateStatus();
     }
+    else
+    {
+        m_progress->finish();
+    }
+    updateActions();
+}
+
+bool KomparePart::useDiffEngine() const
+{
+    if (m_info.mode != Kompare::ComparingFiles && m_info.mode != Kompare::UnknownMode)
+        return false;
+
+    // directories and the fallback to the diff program are left to the model list
+    return QFileInfo(m_info.localSource).isFile() && QFileInfo(m_info.localDestination).isFile()
+           && m_diffSettings->m_builtInDiff && KompareDiffEngine::supports(m_diffSettings);
+}
+
+void KomparePart::slotDiffComputed()
+{
+    if (m_diffEngine.isCanceled())
+        return;
+
+    const KompareDiffResult result = m_diffEngine.result();
+    if (!result.errorString.isEmpty())
+    {
+        m_progress->finish();
+        slotShowError(result.errorString);
+    }
+    else if (result.diff.isEmpty())
+    {
+        m_progress->finish();
+        KMessageBox::information(widget(), i18n("The files are identical."));
+    }
+    else
+    {
+        emit diffString(result.diff);
+        parseLater(QStringList(result.diff));
+        return;
+    }
     updateActions();
+    updateCaption();
+    updateStatus();
 }
 
 void KomparePart::slotShowError(const QString& error)
@@ -833,10 +1182,61 @@ void KomparePart::slotRefreshDiff()
     }
 
     // For this to work properly you have to refetch the files from their (remote) locations
+    cancelLoading();
     cleanUpTemporaryFiles();
     fetchURL(m_info.source, true);
     fetchURL(m_info.destination, false);
-    m_modelList->refresh();
+    whenFetched(&KomparePart::refreshFetched);
+}
+
+void KomparePart::refreshFetched()
+{
+    if (useDiffEngine())
+        compareAndUpdateAll();
+    else
+        m_modelList->refresh();
+}
+
+void KomparePart::slotFind()
+{
+    if (!m_searchDialog) {
+        m_searchDialog = new KompareSearchDialog(widget());
+        connect(m_searchDialog, &KompareSearchDialog::searchRequested,
+                this, &KomparePart::slotSearch);
+        connect(m_searchDialog, &KompareSearchDialog::hitActivated,
+                this, &KomparePart::slotSearchHitActivated);
+        connect(m_search, &KompareSearch::hitsFound,
+                m_searchDialog, &KompareSearchDialog::slotHitsFound);
+        connect(m_search, &KompareSearch::finished,
+                m_searchDialog, &KompareSearchDialog::slotFinished);
+        connect(m_modelList, &KompareModelList::modelsChanged,
+                m_searchDialog, &KompareSearchDialog::slotModelsChanged);
+    }
+
+    m_searchDialog->show();
+    m_searchDialog->raise();
+    m_searchDialog->activateWindow();
+}
+
+void KomparePart::slotSearch(const KompareSearchOptions& options)
+{
+    m_search->start(m_modelList->models(), options);
+}
+
+void KomparePart::slotSearchHitActivated(const KompareSearchHit& hit)
+{
+    // Unchanged differences can not be selected, only their model is
+    if (hit.difference->type() != Difference::Unchanged) {
+        if (hit.model != m_modelList->selectedModel())
+            emit selectionChanged(hit.model, hit.difference);
+        else
+            emit selectionChanged(hit.difference);
+    } else if (hit.model != m_modelList->selectedModel()) {
+        const DifferenceList* differences = const_cast<DiffModel*>(hit.model)->differences();
+        emit selectionChanged(hit.model, differences->isEmpty() ? nullptr : differences->first());
+    }
+
+    m_splitter->scrollToLine(hit.difference, hit.source, hit.line);
 }
 
 void KomparePart::slotShowDiffstats()
@@ -22,14 +22,20 @@
 
 #include <KParts/ReadWritePart>
 
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSharedPointer>
 #include <QVariantList>
 #include <libkomparediff2/kompare.h>
 
 #include <komparepartdebug.h>
 #include "kompareinterface.h"
+#include "komparediffengine.h"
+#include "komparediffindex.h"
 
 class QAction;
 class QPrinter;
+class QTemporaryDir;
 class QUrl;
 class QWidget;
 
@@ -41,10 +47,16 @@ class DiffModel;
 class DiffModelList;
 class KompareModelList;
 }
-class DiffSettings;
+class KompareDiffSettings;
 class ViewSettings;
 class KompareSplitter;
 class KompareView;
+class KompareLoadProgress;
+class KompareSearch;
+class KompareUrlFetcher;
+class KompareSearchDialog;
+struct KompareSearchHit;
+struct KompareSearchOptions;
 
 /**
  * This is a "Part".  It does all the real work in a KPart
@@ -92,14 +104,18 @@ public:
 
 public:
     // Reimplemented from the KompareInterface
-    /**
-     * Open and parse the diff file at diffUrl.
-     */
+    /** Open and parse the diff file at diffUrl, this waits until it is shown */
     bool openDiff(const QUrl& diffUrl) override;
 
+    /** Open and parse the diff file at diffUrl in the background, diffOpened() tells how it went */
+    bool openDiffInBackground(const QUrl& diffUrl) override;
+
     /** Added on request of Harald Fernengel */
     bool openDiff(const QString& diffOutput) override;
 
+    /** Parse the supplied diff output and add its files to the diff that is shown */
+    bool appendDiff(const QString& diffOutput) override;
+
     /** Open and parse the diff3 file at diff3Url */
     bool openDiff3(const QUrl& diff3URL) override;
 
@@ -152,6 +168,9 @@ Q_SIGNALS:
 
     void configChanged();
 
+    /** The diff of openDiffInBackground() is shown, or it failed or was stopped when success is false */
+    void diffOpened(bool success);
+
     /*
     ** This is emitted when a difference is clicked in the kompare view. You can connect to
     ** it so you can use it to jump to this particular line in the editor in your app.
@@ -195,6 +214,10 @@ protected Q_SLOTS:
     void slotSwap();
     void slotShowDiffstats();
     void slotRefreshDiff();
+    void slotFind();
+    void slotStopLoading();
+    void slotSearch(const KompareSearchOptions& options);
+    void slotSearchHitActivated(const KompareSearchHit& hit);
     void optionsPreferences();
 
     void updateActions();
@@ -210,32 +233,82 @@ private:
     bool isDirectory(const QUrl& url);
     // FIXME (like in cpp file not urgent) Replace with enum, cant find a proper
     // name now but it is private anyway so can not be used from outside
-    bool fetchURL(const QUrl& url, bool isSource);
+    void fetchURL(const QUrl& url, bool isSource);
+    void setFetchedURL(bool isSource, const QString& localFile, QTemporaryDir* tmpDir);
+
+    // Remote URLs are downloaded concurrently, the action runs once all of them are here
+    typedef void (KomparePart::*FetchedAction)();
+    void whenFetched(FetchedAction action);
+    void cancelLoading();
+    void finishOpeningDiff(bool success);
+    bool isFetching() const { return !m_fetchers.isEmpty(); }
+    bool isLoading() const { return isFetching() || m_diffReader.isRunning() || m_diffEngine.isRunning() || !m_parseChunks.isEmpty(); }
+    // Two files are compared in process unless the diff program is preferred
+    bool useDiffEngine() const;
+
+    void compareFetched();
+    void openFetchedDiff();
+    void openFetchedDirAndDiff();
+    void refreshFetched();
+    // The parser runs on the GUI thread, a chunk of files at a time with the
+    // event loop running in between. The status bar shows the stage first.
+    void parseLater(const QStringList& chunks);
+    bool appendModels(const QString& diff);
+
+    // A huge diff is shown a page of files at a time
+    int diffPageCount() const;
+    void loadDiffPage(int page);
 
 private Q_SLOTS:
     void onContextMenuRequested(const QPoint& pos);
+    void slotURLFetched(KompareUrlFetcher* fetcher);
+    void slotDiffRead();
+    void slotDiffComputed();
+    void slotParseDiff();
+    void slotModelsParsed();
+    void slotPreviousDiffPage();
+    void slotNextDiffPage();
 
 private:
     // Uhm why were these static again ???
     // Ah yes, so multiple instances of kompare use the
     // same settings after one of them changes them
     static ViewSettings* m_viewSettings;
-    static DiffSettings* m_diffSettings;
+    static KompareDiffSettings* m_diffSettings;
 
     Diff2::KompareModelList* m_modelList;
 
     KompareView*             m_view;
     KompareSplitter*         m_splitter;
+    KompareSearch*           m_search;
+    KompareSearchDialog*     m_searchDialog;
+    KompareLoadProgress*     m_progress;
 
     QAction*                 m_saveAll;
     QAction*                 m_saveDiff;
     QAction*                 m_swap;
     QAction*                 m_diffStats;
     QAction*                 m_diffRefresh;
+    QAction*                 m_find;
+    QAction*                 m_stopLoading;
+    QAction*                 m_previousDiffPage;
+    QAction*                 m_nextDiffPage;
     QAction*                 m_print;
     QAction*                 m_printPreview;
 
     struct Kompare::Info     m_info;
+
+    QHash<KompareUrlFetcher*, bool> m_fetchers; // -> is source
+    FetchedAction            m_fetchedAction;
+    QFutureWatcher<KompareDiffPage> m_diffReader;
+    QFutureWatcher<KompareDiffResult> m_diffEngine;
+    Diff2::KompareModelList* m_sectionParser;  // parses the models that are appended
+    QStringList              m_parseChunks;
+    int                      m_parsedChunks;
+    bool                     m_openingDiff; // until diffOpened() is emitted
+    QString                  m_encoding;
+    QSharedPointer<KompareDiffIndex> m_diffIndex; // of the page that is shown
+    int                      m_diffPage;
 };
 
 #endif // KOMPAREPART_H
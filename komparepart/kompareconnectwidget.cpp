@@ -21,14 +21,16 @@
 
 #include <QApplication>
 #include <QPainter>
-#include <QPixmap>
 #include <QStyle>
 #include <QTimer>
 #include <QPaintEvent>
+#include <QResizeEvent>
 #include <QFrame>
 #include <QMouseEvent>
 #include <QDebug>
+#include <QElapsedTimer>
 
+#include <komparerenderdebug.h>
 #include "viewsettings.h"
 #include "komparelistview.h"
 #include "komparesplitter.h"
@@ -105,7 +107,11 @@ KompareConnectWidget::KompareConnectWidget(ViewSettings* settings, QWidget* pare
     : QWidget(parent),
       m_settings(settings),
       m_selectedModel(nullptr),
-      m_selectedDifference(nullptr)
+      m_selectedDifference(nullptr),
+      m_connectors(1024),
+      m_paints(0),
+      m_connectorsPainted(0),
+      m_paintTime(0)
 {
     setObjectName(QLatin1String(name));
 //     connect( m_settings, SIGNAL( settingsChanged() ), this, SLOT( slotDelayedRepaint() ) );
@@ -128,8 +134,7 @@ void KompareConnectWidget::slotSetSelection(const DiffModel* model, const Differ
 
     if (m_selectedModel == model && m_selectedDifference != diff)
     {
-        m_selectedDifference = diff;
-        slotDelayedRepaint();
+        slotSetSelection(diff);
         return;
     }
 
@@ -149,19 +154,40 @@ void KompareConnectWidget::slotSetSelection(const Difference* diff)
     if (m_selectedDifference == diff)
         return;
 
+    // Only the connectors of the previously and the newly selected difference change
+    update(connectorRect(m_selectedDifference));
     m_selectedDifference = diff;
+    update(connectorRect(m_selectedDifference));
+}
 
-    slotDelayedRepaint();
+QRect KompareConnectWidget::connectorRect(const Difference* diff) const
+{
+    KompareSplitter* splitter = static_cast<KompareSplitter*>(parent()->parent());
+    if (!diff || splitter->count() < 2)
+        return QRect();
+
+    const QRect leftRect = static_cast<KompareListViewFrame*>(splitter->widget(0))->view()->differenceRect(diff);
+    const QRect rightRect = static_cast<KompareListViewFrame*>(splitter->widget(1))->view()->differenceRect(diff);
+    if (leftRect.isNull() || rightRect.isNull())
+        return QRect();
+
+    // one more row for the antialiased edges, the connectors are painted half a pixel down
+    const int top = qMin(leftRect.top(), rightRect.top());
+    const int bottom = qMax(leftRect.bottom(), rightRect.bottom()) + 1;
+    return QRect(0, top, width(), bottom - top + 1).intersected(rect());
 }
 
-void KompareConnectWidget::paintEvent(QPaintEvent* /* e */)
+void KompareConnectWidget::paintEvent(QPaintEvent* e)
 {
-    QPixmap pixbuf(size());
-    QPainter paint(&pixbuf);
+    QElapsedTimer timer;
+    timer.start();
+    int painted = 0;
+
+    QPainter paint(this);
     QPainter* p = &paint;
 
     p->setRenderHint(QPainter::Antialiasing);
-    p->fillRect(0, 0, pixbuf.width(), pixbuf.height(), palette().color(QPalette::Window));
+    p->fillRect(0, 0, width(), height(), palette().color(QPalette::Window));
     p->translate(QPointF(0, 0.5));
 
     KompareSplitter* splitter = static_cast<KompareSplitter*>(parent()->parent());
@@ -207,37 +233,80 @@ void KompareConnectWidget::paintEvent(QPaintEvent* /* e */)
                 int br = rightRect.bottom();
 
                 // Bah, stupid 16-bit signed shorts in that crappy X stuff...
-                tl = tl >= -32768 ? tl : -32768;
-                tr = tr >= -32768 ? tr : -32768;
-                bl = bl <=  32767 ? bl :  32767;
-                br = br <=  32767 ? br :  32767;
+                // A huge one sided difference can push any corner far out either way
+                tl = qBound(-32768, tl, 32767);
+                tr = qBound(-32768, tr, 32767);
+                bl = qBound(-32768, bl, 32767);
+                br = qBound(-32768, br, 32767);
 
-                QPainterPath topBezier = makeBezier(tl, tr);
-                QPainterPath bottomBezier = makeBezier(bl, br);
+                // a selection change only damages the rows of two connectors
+                if (qMax(bl, br) + 1 < e->rect().top() || qMin(tl, tr) > e->rect().bottom())
+                    continue;
 
-                QPainterPath poly(topBezier);
-                poly.connectPath(bottomBezier.toReversed());
-                poly.closeSubpath();
+                // The shape only depends on the corners relative to the top left one
+                const Connector* connector = this->connector(tr - tl, bl - tl, br - tl);
+                p->save();
+                p->translate(0, tl);
 
                 QColor bg = m_settings->colorForDifferenceType(diff->type(), selected, diff->applied());
                 p->setPen(bg);
                 p->setBrush(bg);
-                p->drawPath(poly);
+                p->drawPath(connector->polygon);
 
                 if (selected)
                 {
                     p->setPen(bg.darker(135));
                     p->setBrush(Qt::NoBrush);
-                    p->drawPath(topBezier);
-                    p->drawPath(bottomBezier.toReversed());
+                    p->drawPath(connector->top);
+                    p->drawPath(connector->bottom);
                 }
+
+                p->restore();
+                ++painted;
             }
         }
     }
 
-//     p->flush();
-    QPainter widgetPainter(this);
-    widgetPainter.drawImage(0, 0, pixbuf.toImage());
+    p->end();
+    m_paintTime += timer.nsecsElapsed();
+    m_connectorsPainted += painted;
+    if (++m_paints >= 500) {
+        qCDebug(KOMPARERENDER) << "Connectors:" << m_paints << "paints," << m_connectorsPainted << "connectors,"
+                               << m_paintTime / 1000 << "us painting";
+        m_paints = 0;
+        m_connectorsPainted = 0;
+        m_paintTime = 0;
+    }
+}
+
+const KompareConnectWidget::Connector* KompareConnectWidget::connector(int topRight, int bottomLeft, int bottomRight)
+{
+    // the corners are clamped to 16 bits in paintEvent()
+    Q_ASSERT(qAbs(topRight) <= 65535 && qAbs(bottomLeft) <= 65535 && qAbs(bottomRight) <= 65535);
+    const ConnectorKey key = { topRight, bottomLeft, bottomRight };
+
+    Connector* connector = m_connectors.object(key);
+    if (!connector)
+    {
+        connector = new Connector;
+        connector->top = makeBezier(0, topRight);
+        QPainterPath bottomBezier = makeBezier(bottomLeft, bottomRight);
+        connector->bottom = bottomBezier.toReversed();
+
+        connector->polygon = connector->top;
+        connector->polygon.connectPath(connector->bottom);
+        connector->polygon.closeSubpath();
+        m_connectors.insert(key, connector);
+    }
+    return connector;
+}
+
+void KompareConnectWidget::resizeEvent(QResizeEvent* e)
+{
+    // the curves span the width of the widget
+    if (e->size().width() != e->oldSize().width())
+        m_connectors.clear();
+    QWidget::resizeEvent(e);
 }
 
 QPainterPath KompareConnectWidget::makeBezier(int leftHeight, int rightHeight) const
@@ -21,6 +21,8 @@
 #define KOMPARECONNECTWIDGET_H
 
 #include <QWidget>
+#include <QCache>
+#include <QPainterPath>
 #include <QSplitter>
 #include <QPaintEvent>
 #include <QMouseEvent>
@@ -54,13 +56,50 @@ Q_SIGNALS:
 
 protected:
     void paintEvent(QPaintEvent* e) override;
+    void resizeEvent(QResizeEvent* e) override;
     QPainterPath makeBezier(int l, int r) const;
 
 private:
+    // The shape between a difference in both views, with its top left corner at 0
+    struct Connector
+    {
+        QPainterPath polygon;
+        QPainterPath top;
+        QPainterPath bottom;
+    };
+
+    // The corners of a connector relative to its top left one
+    struct ConnectorKey
+    {
+        int topRight;
+        int bottomLeft;
+        int bottomRight;
+
+        bool operator==(const ConnectorKey& other) const
+        {
+            return topRight == other.topRight && bottomLeft == other.bottomLeft && bottomRight == other.bottomRight;
+        }
+        friend uint qHash(const ConnectorKey& key, uint seed = 0)
+        {
+            return qHash(qMakePair(key.topRight, qMakePair(key.bottomLeft, key.bottomRight)), seed);
+        }
+    };
+
+    const Connector* connector(int topRight, int bottomLeft, int bottomRight);
+    QRect connectorRect(const Diff2::Difference* diff) const;
+
     ViewSettings*             m_settings;
 
     const Diff2::DiffModel*   m_selectedModel;
     const Diff2::Difference*  m_selectedDifference;
+
+    // Keyed on the corners relative to the top left one, dropped when the width changes
+    QCache<ConnectorKey, Connector> m_connectors;
+
+    // Logged and reset every few hundred paints
+    int                       m_paints;
+    int                       m_connectorsPainted;
+    qint64                    m_paintTime;
 };
 
 class KompareConnectWidgetFrame : public QSplitterHandle
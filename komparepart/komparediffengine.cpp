@@ -0,0 +1,501 @@
+/***************************************************************************
+                                komparediffengine.cpp
+                                ---------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparediffengine.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureInterface>
+#include <QHash>
+#include <QTextCodec>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <KLocalizedString>
+
+#include <libkomparediff2/diffsettings.h>
+#include <libkomparediff2/kompare.h>
+
+#include <climits>
+
+#include <komparepartdebug.h>
+
+#define TAB_WIDTH 8
+
+static QString expandTabs(const QString& line)
+{
+    if (!line.contains(QLatin1Char('\t')))
+        return line;
+
+    QString expanded;
+    expanded.reserve(line.size() + TAB_WIDTH);
+    for (const QChar c : line) {
+        if (c == QLatin1Char('\t'))
+            expanded += QString(TAB_WIDTH - expanded.size() % TAB_WIDTH, QLatin1Char(' '));
+        else
+            expanded += c;
+    }
+    return expanded;
+}
+
+// The lines of a hunk as GNU diff writes them, the count is left out for one line
+// and an empty range has the number of the line before it
+static QString unifiedRange(int begin, int end)
+{
+    if (end - begin == 1)
+        return QString::number(end);
+    return QString::number(end > begin ? begin + 1 : begin) + QLatin1Char(',') + QString::number(end - begin);
+}
+
+/**
+ * Marks the lines that are not part of a shortest edit script between a
+ * and b, splitting the problem at the middle snake of every edit path
+ * like GNU diff does, so it only needs memory linear in the input.
+ *
+ * Like GNU diff it gives up on a middle snake that is too expensive to
+ * find and splits at the furthest point reached instead, the script is
+ * then no longer the shortest, unless it has to be minimal. The comparison
+ * stops when future is cancelled.
+ */
+class KompareLineDiff
+{
+public:
+    KompareLineDiff(const QVector<int>& a, const QVector<int>& b, bool minimal, const QFutureInterfaceBase& future) :
+        m_a(a),
+        m_b(b),
+        m_future(future),
+        m_changedA(a.size(), false),
+        m_changedB(b.size(), false),
+        m_forward(a.size() + b.size() + 3),
+        m_backward(a.size() + b.size() + 3),
+        m_offset(b.size() + 1),
+        m_tooExpensive(1),
+        m_canceled(false)
+    {
+        // about the square root of the number of diagonals, at least 4096
+        for (int diagonals = a.size() + b.size() + 3; diagonals != 0; diagonals >>= 2)
+            m_tooExpensive <<= 1;
+        m_tooExpensive = minimal ? INT_MAX : qMax(m_tooExpensive, 4096);
+
+        compare(0, a.size(), 0, b.size());
+    }
+
+    bool changedA(int line) const { return m_changedA.at(line); }
+    bool changedB(int line) const { return m_changedB.at(line); }
+    bool canceled() const { return m_canceled; }
+
+private:
+    void compare(int xoff, int xlim, int yoff, int ylim)
+    {
+        if (m_canceled)
+            return;
+
+        while (xoff < xlim && yoff < ylim && m_a.at(xoff) == m_b.at(yoff)) {
+            ++xoff;
+            ++yoff;
+        }
+        while (xlim > xoff && ylim > yoff && m_a.at(xlim - 1) == m_b.at(ylim - 1)) {
+            --xlim;
+            --ylim;
+        }
+
+        if (xoff == xlim) {
+            for (int y = yoff; y < ylim; ++y)
+                m_changedB[y] = true;
+        } else if (yoff == ylim) {
+            for (int x = xoff; x < xlim; ++x)
+                m_changedA[x] = true;
+        } else {
+            int xmid, ymid;
+            middleSnake(xoff, xlim, yoff, ylim, xmid, ymid);
+            compare(xoff, xmid, yoff, ymid);
+            compare(xmid, xlim, ymid, ylim);
+        }
+    }
+
+    int& fd(int diagonal) { return m_forward[diagonal + m_offset]; }
+    int& bd(int diagonal) { return m_backward[diagonal + m_offset]; }
+
+    void middleSnake(int xoff, int xlim, int yoff, int ylim, int& xmid, int& ymid)
+    {
+        const int dmin = xoff - ylim;
+        const int dmax = xlim - yoff;
+        const int fmid = xoff - yoff;
+        const int bmid = xlim - ylim;
+        const bool odd = (fmid - bmid) & 1;
+        int fmin = fmid, fmax = fmid;
+        int bmin = bmid, bmax = bmid;
+
+        fd(fmid) = xoff;
+        bd(bmid) = xlim;
+
+        for (int cost = 1;; ++cost) {
+            if (m_future.isCanceled()) {
+                // compare() does not go on, any split will do
+                m_canceled = true;
+                xmid = xoff;
+                ymid = yoff;
+                return;
+            }
+
+            if (fmin > dmin)
+                fd(--fmin - 1) = -1;
+            else
+                ++fmin;
+            if (fmax < dmax)
+                fd(++fmax + 1) = -1;
+            else
+                --fmax;
+            for (int d = fmax; d >= fmin; d -= 2) {
+                const int tlo = fd(d - 1);
+                const int thi = fd(d + 1);
+                int x = tlo >= thi ? tlo + 1 : thi;
+                int y = x - d;
+                while (x < xlim && y < ylim && m_a.at(x) == m_b.at(y)) {
+                    ++x;
+                    ++y;
+                }
+                fd(d) = x;
+                if (odd && bmin <= d && d <= bmax && bd(d) <= x) {
+                    xmid = x;
+                    ymid = y;
+                    return;
+                }
+            }
+
+            if (bmin > dmin)
+                bd(--bmin - 1) = INT_MAX;
+            else
+                ++bmin;
+            if (bmax < dmax)
+                bd(++bmax + 1) = INT_MAX;
+            else
+                --bmax;
+            for (int d = bmax; d >= bmin; d -= 2) {
+                const int tlo = bd(d - 1);
+                const int thi = bd(d + 1);
+                int x = tlo < thi ? tlo : thi - 1;
+                int y = x - d;
+                while (x > xoff && y > yoff && m_a.at(x - 1) == m_b.at(y - 1)) {
+                    --x;
+                    --y;
+                }
+                bd(d) = x;
+                if (!odd && fmin <= d && d <= fmax && x <= fd(d)) {
+                    xmid = x;
+                    ymid = y;
+                    return;
+                }
+            }
+
+            if (cost >= m_tooExpensive) {
+                splitExpensive(xoff, xlim, yoff, ylim, fmin, fmax, bmin, bmax, xmid, ymid);
+                return;
+            }
+        }
+    }
+
+    // Splits at the point furthest from the start or the end
+    void splitExpensive(int xoff, int xlim, int yoff, int ylim, int fmin, int fmax, int bmin, int bmax, int& xmid, int& ymid)
+    {
+        int fxybest = -1;
+        int fxbest = xoff;
+        for (int d = fmax; d >= fmin; d -= 2) {
+            int x = qMin(fd(d), xlim);
+            int y = x - d;
+            if (ylim < y) {
+                x = ylim + d;
+                y = ylim;
+            }
+            if (fxybest < x + y) {
+                fxybest = x + y;
+                fxbest = x;
+            }
+        }
+
+        int bxybest = INT_MAX;
+        int bxbest = xlim;
+        for (int d = bmax; d >= bmin; d -= 2) {
+            int x = qMax(xoff, bd(d));
+            int y = x - d;
+            if (y < yoff) {
+                x = yoff + d;
+                y = yoff;
+            }
+            if (x + y < bxybest) {
+                bxybest = x + y;
+                bxbest = x;
+            }
+        }
+
+        if ((xlim + ylim) - bxybest < fxybest - (xoff + yoff)) {
+            xmid = fxbest;
+            ymid = fxybest - fxbest;
+        } else {
+            xmid = bxbest;
+            ymid = bxybest - bxbest;
+        }
+    }
+
+    const QVector<int>&         m_a;
+    const QVector<int>&         m_b;
+    const QFutureInterfaceBase& m_future;
+    QVector<bool>               m_changedA;
+    QVector<bool>               m_changedB;
+    QVector<int>                m_forward;
+    QVector<int>                m_backward;
+    int                         m_offset;
+    int                         m_tooExpensive; // iterations before a middle snake is given up
+    bool                        m_canceled;
+};
+
+KompareDiffEngine::KompareDiffEngine(const DiffSettings* settings) :
+    m_linesOfContext(settings->m_linesOfContext),
+    m_ignoreChangesInCase(settings->m_ignoreChangesInCase),
+    m_ignoreWhiteSpace(settings->m_ignoreWhiteSpace),
+    m_ignoreAllWhiteSpace(settings->m_ignoreAllWhiteSpace),
+    m_ignoreChangesDueToTabExpansion(settings->m_ignoreChangesDueToTabExpansion),
+    m_ignoreEmptyLines(settings->m_ignoreEmptyLines),
+    m_convertTabsToSpaces(settings->m_convertTabsToSpaces),
+    m_minimal(settings->m_createSmallerDiff)
+{
+    if (settings->m_ignoreRegExp && !settings->m_ignoreRegExpText.isEmpty())
+    {
+        m_ignoreRegExp.setPattern(settings->m_ignoreRegExpText);
+        if (!m_ignoreRegExp.isValid())
+        {
+            qCDebug(KOMPAREPART) << "Ignoring invalid regular expression " << settings->m_ignoreRegExpText;
+            m_ignoreRegExp = QRegularExpression();
+        }
+    }
+}
+
+bool KompareDiffEngine::supports(const DiffSettings* settings)
+{
+    // a program of its own, function names in the hunk headers and other
+    // formats than unified are left to the diff program
+    return settings->m_diffProgram.isEmpty()
+           && !settings->m_showCFunctionChange
+           && settings->m_format == Kompare::Unified;
+}
+
+bool KompareDiffEngine::readLines(const QString& fileName, const QString& encoding, Lines& lines) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QTextCodec* codec = encoding.isEmpty() ? nullptr : QTextCodec::codecForName(encoding.toLatin1());
+    const QString text = (codec ? codec : QTextCodec::codecForLocale())->toUnicode(file.readAll());
+
+    lines.text = text.split(QLatin1Char('\n'));
+    lines.newlineAtEnd = text.isEmpty() || text.endsWith(QLatin1Char('\n'));
+    // split leaves an empty line after the last newline
+    if (lines.newlineAtEnd)
+        lines.text.removeLast();
+    return true;
+}
+
+QString KompareDiffEngine::key(const QString& line) const
+{
+    const QString expanded = m_ignoreChangesDueToTabExpansion ? expandTabs(line) : line;
+    if (!m_ignoreWhiteSpace && !m_ignoreAllWhiteSpace)
+        return m_ignoreChangesInCase ? expanded.toCaseFolded() : expanded;
+
+    // only the amount of white space may not matter, so leading white space still does
+    QString key;
+    key.reserve(expanded.size());
+    bool space = false;
+    for (const QChar c : expanded) {
+        if (c.isSpace()) {
+            space = true;
+            continue;
+        }
+        if (space && !m_ignoreAllWhiteSpace)
+            key += QLatin1Char(' ');
+        space = false;
+        key += c;
+    }
+
+    if (m_ignoreChangesInCase)
+        key = key.toCaseFolded();
+
+    return key;
+}
+
+bool KompareDiffEngine::isIgnorable(const QString& line) const
+{
+    if (m_ignoreEmptyLines && (m_ignoreWhiteSpace || m_ignoreAllWhiteSpace ? line.trimmed().isEmpty() : line.isEmpty()))
+        return true;
+
+    return !m_ignoreRegExp.pattern().isEmpty() && m_ignoreRegExp.match(line).hasMatch();
+}
+
+QString KompareDiffEngine::outputLine(const QString& line) const
+{
+    return m_convertTabsToSpaces ? expandTabs(line) : line;
+}
+
+static void computeDiff(QFutureInterface<KompareDiffResult> future, const KompareDiffEngine& engine,
+                        const QString& source, const QString& destination, const QString& encoding)
+{
+    const KompareDiffResult result = engine.diff(source, destination, encoding, future);
+    if (!future.isCanceled())
+        future.reportResult(result);
+    future.reportFinished();
+}
+
+QFuture<KompareDiffResult> KompareDiffEngine::start(const QString& source, const QString& destination, const QString& encoding) const
+{
+    QFutureInterface<KompareDiffResult> future;
+    future.reportStarted();
+    QtConcurrent::run(computeDiff, future, *this, source, destination, encoding);
+    return future.future();
+}
+
+KompareDiffResult KompareDiffEngine::diff(const QString& source, const QString& destination, const QString& encoding,
+                                          const QFutureInterfaceBase& future) const
+{
+    KompareDiffResult result;
+
+    Lines a, b;
+    if (!readLines(source, encoding, a))
+    {
+        result.errorString = i18n("<qt>The file <b>%1</b> cannot be read.</qt>", source);
+        return result;
+    }
+    if (!readLines(destination, encoding, b))
+    {
+        result.errorString = i18n("<qt>The file <b>%1</b> cannot be read.</qt>", destination);
+        return result;
+    }
+
+    // Equal lines get the same number, a last line without a newline
+    // never equals one with a newline
+    QHash<QString, int> numbers;
+    auto number = [&](const Lines& lines, QVector<int>& out) {
+        out.reserve(lines.text.size());
+        for (int i = 0; i < lines.text.size(); ++i) {
+            QString lineKey = key(lines.text.at(i));
+            if (i == lines.text.size() - 1 && !lines.newlineAtEnd)
+                lineKey += QChar(0);
+            QHash<QString, int>::const_iterator it = numbers.constFind(lineKey);
+            if (it == numbers.constEnd())
+                it = numbers.insert(lineKey, numbers.size());
+            out.append(it.value());
+        }
+    };
+    QVector<int> aNumbers, bNumbers;
+    number(a, aNumbers);
+    number(b, bNumbers);
+    numbers.clear();
+
+    const KompareLineDiff lineDiff(aNumbers, bNumbers, m_minimal, future);
+    if (lineDiff.canceled())
+        return result;
+
+    struct Change
+    {
+        int aBegin, aEnd, bBegin, bEnd;
+        bool ignorable;
+    };
+    QVector<Change> changes;
+    const int aCount = a.text.size();
+    const int bCount = b.text.size();
+    for (int i = 0, j = 0; i < aCount || j < bCount;)
+    {
+        if ((i < aCount && lineDiff.changedA(i)) || (j < bCount && lineDiff.changedB(j)))
+        {
+            Change change = { i, i, j, j, true };
+            while (change.aEnd < aCount && lineDiff.changedA(change.aEnd))
+                change.ignorable = isIgnorable(a.text.at(change.aEnd++)) && change.ignorable;
+            while (change.bEnd < bCount && lineDiff.changedB(change.bEnd))
+                change.ignorable = isIgnorable(b.text.at(change.bEnd++)) && change.ignorable;
+            if (!m_ignoreEmptyLines && m_ignoreRegExp.pattern().isEmpty())
+                change.ignorable = false;
+            changes.append(change);
+            i = change.aEnd;
+            j = change.bEnd;
+        }
+        else
+        {
+            ++i;
+            ++j;
+        }
+    }
+
+    const QString noNewline = QStringLiteral("\\ No newline at end of file\n");
+    QString& out = result.diff;
+    const int context = qMax(m_linesOfContext, 0);
+    for (int first = 0; first < changes.size();)
+    {
+        // changes closer than twice the context share a hunk, one that only
+        // has ignorable changes is left out
+        int last = first;
+        bool ignorable = changes.at(first).ignorable;
+        while (last + 1 < changes.size())
+        {
+            // like in GNU diff an ignorable change only joins a hunk within the context
+            const Change& next = changes.at(last + 1);
+            if (next.aBegin - changes.at(last).aEnd > (next.ignorable ? context - 1 : 2 * context))
+                break;
+            ignorable = next.ignorable && ignorable;
+            ++last;
+        }
+
+        if (!ignorable)
+        {
+            if (out.isEmpty())
+            {
+                const QString timeFormat = QStringLiteral("yyyy-MM-dd hh:mm:ss.zzz");
+                out += QLatin1String("--- ") + source + QLatin1Char('\t') + QFileInfo(source).lastModified().toString(timeFormat) + QLatin1Char('\n');
+                out += QLatin1String("+++ ") + destination + QLatin1Char('\t') + QFileInfo(destination).lastModified().toString(timeFormat) + QLatin1Char('\n');
+            }
+
+            const int aBegin = qMax(changes.at(first).aBegin - context, 0);
+            const int aEnd = qMin(changes.at(last).aEnd + context, aCount);
+            const int bBegin = changes.at(first).bBegin - (changes.at(first).aBegin - aBegin);
+            const int bEnd = changes.at(last).bEnd + (aEnd - changes.at(last).aEnd);
+            out += QLatin1String("@@ -") + unifiedRange(aBegin, aEnd)
+                   + QLatin1String(" +") + unifiedRange(bBegin, bEnd) + QLatin1String(" @@\n");
+
+            auto writeLine = [&](QChar type, const Lines& lines, int line) {
+                out += type + outputLine(lines.text.at(line)) + QLatin1Char('\n');
+                if (line == lines.text.size() - 1 && !lines.newlineAtEnd)
+                    out += noNewline;
+            };
+
+            int i = aBegin;
+            for (int change = first; change <= last; ++change)
+            {
+                const Change& c = changes.at(change);
+                for (; i < c.aBegin; ++i)
+                    writeLine(QLatin1Char(' '), a, i);
+                for (; i < c.aEnd; ++i)
+                    writeLine(QLatin1Char('-'), a, i);
+                for (int j = c.bBegin; j < c.bEnd; ++j)
+                    writeLine(QLatin1Char('+'), b, j);
+            }
+            for (; i < aEnd; ++i)
+                writeLine(QLatin1Char(' '), a, i);
+        }
+
+        first = last + 1;
+    }
+
+    return result;
+}
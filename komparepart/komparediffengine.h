@@ -0,0 +1,91 @@
+/***************************************************************************
+                                komparediffengine.h
+                                -------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPAREDIFFENGINE_H
+#define KOMPAREDIFFENGINE_H
+
+#include <QFuture>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+
+class DiffSettings;
+class QFutureInterfaceBase;
+
+struct KompareDiffResult
+{
+    /** Unified diff output, empty when the files do not differ */
+    QString diff;
+    /** Empty unless a file could not be read */
+    QString errorString;
+};
+
+/**
+ * Compares two files without running the diff program.
+ *
+ * The lines are compared with the linear space variant of Myers' algorithm
+ * and the differences are written as the text "diff -U" writes. The model
+ * list parses that text like the output of the diff program, the engine
+ * only saves starting the process and reading its output. The options of
+ * the Diff page that change what is compared are honored: ignoring case,
+ * white space, tab expansion, blank lines and lines matching a regular
+ * expression, as well as the lines of context and converting tabs to
+ * spaces. For those the hunks are the same as the ones of GNU diff.
+ *
+ * Like GNU diff the engine stops looking for the shortest script where
+ * that gets too expensive, so very different files do not take forever,
+ * unless it is told to look for smaller changes. Optimizing for large
+ * files only makes GNU diff give up sooner, the engine ignores it.
+ */
+class KompareDiffEngine
+{
+public:
+    explicit KompareDiffEngine(const DiffSettings* settings);
+
+    /** False when the settings ask for output only the diff program writes */
+    static bool supports(const DiffSettings* settings);
+
+    /** Compares the files on a worker thread, cancelling the future stops it without a result */
+    QFuture<KompareDiffResult> start(const QString& source, const QString& destination, const QString& encoding) const;
+
+    /** Compares the files until future is cancelled, the engine copies the settings so this may run on any thread */
+    KompareDiffResult diff(const QString& source, const QString& destination, const QString& encoding,
+                           const QFutureInterfaceBase& future) const;
+
+private:
+    struct Lines
+    {
+        QStringList text;
+        bool        newlineAtEnd;
+    };
+
+    bool readLines(const QString& fileName, const QString& encoding, Lines& lines) const;
+    QString key(const QString& line) const;
+    bool isIgnorable(const QString& line) const;
+    QString outputLine(const QString& line) const;
+
+    int                 m_linesOfContext;
+    bool                m_ignoreChangesInCase;
+    bool                m_ignoreWhiteSpace;
+    bool                m_ignoreAllWhiteSpace;
+    bool                m_ignoreChangesDueToTabExpansion;
+    bool                m_ignoreEmptyLines;
+    bool                m_convertTabsToSpaces;
+    bool                m_minimal;
+    QRegularExpression  m_ignoreRegExp;
+};
+
+#endif
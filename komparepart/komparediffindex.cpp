@@ -0,0 +1,126 @@
+/***************************************************************************
+                                komparediffindex.cpp
+                                --------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparediffindex.h"
+#include "komparediffscanner.h"
+
+#include <QTextCodec>
+
+#include <cstring>
+
+#include <komparepartdebug.h>
+
+#define DIFF_PAGE_SIZE (32 * 1024 * 1024)
+
+KompareDiffIndex::KompareDiffIndex() :
+    m_data(nullptr),
+    m_size(0),
+    m_pageSize(DIFF_PAGE_SIZE)
+{
+}
+
+KompareDiffIndex::~KompareDiffIndex()
+{
+}
+
+bool KompareDiffIndex::open(const QString& fileName)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    m_size = m_file.size();
+    m_offsets.clear();
+    m_pages.clear();
+    if (m_size == 0)
+        return true;
+
+    m_data = reinterpret_cast<const char*>(m_file.map(0, m_size));
+    if (!m_data)
+    {
+        qCDebug(KOMPAREPART) << "Could not map " << fileName << ": " << m_file.errorString();
+        return false;
+    }
+
+    KompareDiffScanner scanner;
+    qint64 previous = 0;
+    qint64 pageStart = 0;
+    for (qint64 pos = 0; pos < m_size;)
+    {
+        const char* line = m_data + pos;
+        const char* newline = static_cast<const char*>(std::memchr(line, '\n', m_size - pos));
+        const qint64 length = newline ? newline - line : m_size - pos;
+
+        switch (scanner.addLine(line, length))
+        {
+        case KompareDiffScanner::AtLine:
+            m_offsets.append(pos);
+            break;
+        case KompareDiffScanner::AtPreviousLine:
+            m_offsets.append(previous);
+            break;
+        case KompareDiffScanner::NoBoundary:
+            break;
+        }
+
+        previous = pos;
+        pos += length + 1;
+    }
+
+    // whatever comes before the first header goes with the first section
+    if (m_offsets.isEmpty())
+        m_offsets.append(0);
+    m_offsets[0] = 0;
+
+    for (int file = 0; file < m_offsets.size(); ++file)
+    {
+        if (file == 0 || m_offsets.at(file) - pageStart >= m_pageSize)
+        {
+            m_pages.append(file);
+            pageStart = m_offsets.at(file);
+        }
+    }
+
+    qCDebug(KOMPAREPART) << "Indexed " << m_offsets.size() << " files on " << m_pages.size() << " pages";
+    return true;
+}
+
+int KompareDiffIndex::endFile(int page) const
+{
+    return page + 1 < m_pages.size() ? m_pages.at(page + 1) : m_offsets.size();
+}
+
+qint64 KompareDiffIndex::offset(int file) const
+{
+    return file < m_offsets.size() ? m_offsets.at(file) : m_size;
+}
+
+QStringList KompareDiffIndex::chunks(int page, QTextCodec* codec, qint64 chunkSize) const
+{
+    QStringList chunks;
+    if (page < 0 || page >= m_pages.size())
+        return chunks;
+
+    const int end = endFile(page);
+    for (int file = firstFile(page); file < end;)
+    {
+        const qint64 begin = offset(file);
+        while (++file < end && offset(file) - begin < chunkSize)
+            ;
+        chunks << codec->toUnicode(m_data + begin, offset(file) - begin);
+    }
+    return chunks;
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+                                komparediffindex.h
+                                ------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPAREDIFFINDEX_H
+#define KOMPAREDIFFINDEX_H
+
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QTextCodec;
+
+/**
+ * A memory mapped diff file with the offsets of its file sections.
+ *
+ * Only the file headers are looked at when it is opened, the sections
+ * are grouped into pages of about DIFF_PAGE_SIZE bytes, or the size set
+ * with setPageSize() before it is opened. A page is only
+ * decoded when it is asked for, so a huge patch never has to be in
+ * memory as a whole. A diff smaller than a page has a single page.
+ *
+ * open() may run on a worker thread, after that the index is only read.
+ * It is not shared with the GUI thread before it is open.
+ */
+class KompareDiffIndex
+{
+public:
+    KompareDiffIndex();
+    ~KompareDiffIndex();
+
+    void setPageSize(qint64 pageSize) { m_pageSize = pageSize; }
+    bool open(const QString& fileName);
+
+    int fileCount() const { return m_offsets.size(); }
+    int pageCount() const { return m_pages.size(); }
+    /** The first file of page */
+    int firstFile(int page) const { return m_pages.at(page); }
+    /** One past the last file of page */
+    int endFile(int page) const;
+
+    /** The text of the files on page, cut between files into chunks of at least chunkSize bytes */
+    QStringList chunks(int page, QTextCodec* codec, qint64 chunkSize) const;
+
+private:
+    Q_DISABLE_COPY(KompareDiffIndex)
+
+    qint64 offset(int file) const;
+
+    QFile            m_file;
+    const char*      m_data;
+    qint64           m_size;
+    qint64           m_pageSize;
+    // where the file sections begin
+    QVector<qint64>  m_offsets;
+    // the first file section on every page
+    QVector<int>     m_pages;
+};
+
+/** A page of a diff file that was read on a worker thread */
+struct KompareDiffPage
+{
+    QSharedPointer<KompareDiffIndex> index;   // null when the file could not be read
+    int                              page;
+    QStringList                      chunks;
+};
+
+#endif
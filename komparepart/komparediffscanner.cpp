@@ -0,0 +1,169 @@
+/***************************************************************************
+                                komparediffscanner.cpp
+                                ----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparediffscanner.h"
+
+#include <cstring>
+
+static bool startsWith(const char* line, qint64 length, const char* prefix)
+{
+    const qint64 prefixLength = qstrlen(prefix);
+    return length >= prefixLength && std::memcmp(line, prefix, prefixLength) == 0;
+}
+
+// Reads a number at pos, false when there is no digit
+static bool readNumber(const char* line, qint64 length, qint64& pos, qint64& number)
+{
+    const qint64 start = pos;
+    for (number = 0; pos < length && line[pos] >= '0' && line[pos] <= '9'; ++pos)
+        number = number * 10 + line[pos] - '0';
+    return pos > start;
+}
+
+// Reads "first[,last]" or "first[,count]" at pos, second is -1 without the comma
+static bool readRange(const char* line, qint64 length, qint64& pos, qint64& first, qint64& second)
+{
+    if (!readNumber(line, length, pos, first))
+        return false;
+    second = -1;
+    if (pos < length && line[pos] == ',')
+        return readNumber(line, length, ++pos, second);
+    return true;
+}
+
+// "@@ -l[,s] +l[,s] @@", the number of lines on either side
+static bool unifiedHunk(const char* line, qint64 length, qint64& sourceLines, qint64& destinationLines)
+{
+    if (!startsWith(line, length, "@@ -"))
+        return false;
+
+    qint64 pos = 4;
+    qint64 first;
+    if (!readRange(line, length, pos, first, sourceLines) || !startsWith(line + pos, length - pos, " +"))
+        return false;
+    pos += 2;
+    if (!readRange(line, length, pos, first, destinationLines) || !startsWith(line + pos, length - pos, " @@"))
+        return false;
+
+    if (sourceLines < 0)
+        sourceLines = 1;
+    if (destinationLines < 0)
+        destinationLines = 1;
+    return true;
+}
+
+// "*** l[,l] ****" or "--- l[,l] ----", the line ranges of a context hunk
+static bool contextRange(const char* line, qint64 length)
+{
+    if (length > 0 && line[length - 1] == '\r')
+        --length;
+
+    const char* suffix;
+    if (startsWith(line, length, "*** "))
+        suffix = " ****";
+    else if (startsWith(line, length, "--- "))
+        suffix = " ----";
+    else
+        return false;
+
+    qint64 pos = 4;
+    qint64 first, last;
+    return readRange(line, length, pos, first, last) && length - pos == 5 && std::memcmp(line + pos, suffix, 5) == 0;
+}
+
+// The lines of a context hunk are marked by two characters
+static bool contextLine(const char* line, qint64 length)
+{
+    return length == 0 || line[0] == '\\'
+           || startsWith(line, length, "  ") || startsWith(line, length, "- ")
+           || startsWith(line, length, "+ ") || startsWith(line, length, "! ");
+}
+
+KompareDiffScanner::KompareDiffScanner() :
+    m_headerOpen(false),
+    m_contextHunk(false),
+    m_sourceLines(0),
+    m_destinationLines(0),
+    m_previous(OtherLine)
+{
+}
+
+KompareDiffScanner::Boundary KompareDiffScanner::addLine(const char* line, qint64 length)
+{
+    if (m_sourceLines > 0 || m_destinationLines > 0)
+    {
+        // a hunk that is shorter than it says ends at the first line it has no room for
+        const char type = length > 0 ? line[0] : ' ';
+        const bool source = m_sourceLines > 0 && type != '+';
+        const bool destination = m_destinationLines > 0 && type != '-';
+        if (type == '\\' || (type == ' ' && source && destination)
+            || (type == '-' && source) || (type == '+' && destination))
+        {
+            if (type != '\\')
+            {
+                m_sourceLines -= source;
+                m_destinationLines -= destination;
+            }
+            m_previous = OtherLine;
+            return NoBoundary;
+        }
+        m_sourceLines = m_destinationLines = 0;
+    }
+
+    if (m_contextHunk)
+    {
+        if (contextRange(line, length) || contextLine(line, length))
+        {
+            m_previous = OtherLine;
+            return NoBoundary;
+        }
+        m_contextHunk = false;
+    }
+
+    Boundary boundary = NoBoundary;
+    if (startsWith(line, length, "diff ") || startsWith(line, length, "Index: "))
+    {
+        if (!m_headerOpen)
+            boundary = AtLine;
+        m_headerOpen = true;
+    }
+    else if (startsWith(line, length, "@@ "))
+    {
+        m_headerOpen = false;
+        if (!unifiedHunk(line, length, m_sourceLines, m_destinationLines))
+            m_sourceLines = m_destinationLines = 0;
+    }
+    else if (startsWith(line, length, "***************"))
+    {
+        m_headerOpen = false;
+        m_contextHunk = true;
+    }
+    else if (!m_headerOpen
+             && ((m_previous == MinusLine && startsWith(line, length, "+++ "))
+                 || (m_previous == StarLine && startsWith(line, length, "--- ") && !contextRange(line, length))))
+    {
+        boundary = AtPreviousLine;
+        m_headerOpen = true;
+    }
+
+    if (startsWith(line, length, "--- "))
+        m_previous = MinusLine;
+    else if (startsWith(line, length, "*** ") && !contextRange(line, length))
+        m_previous = StarLine;
+    else
+        m_previous = OtherLine;
+    return boundary;
+}
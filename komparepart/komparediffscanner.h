@@ -0,0 +1,58 @@
+/***************************************************************************
+                                komparediffscanner.h
+                                --------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPAREDIFFSCANNER_H
+#define KOMPAREDIFFSCANNER_H
+
+#include <QtGlobal>
+
+/**
+ * Finds where the file sections of a diff begin, looking at a line at a time.
+ *
+ * A "diff" or "Index:" line begins a file section, so does a pair of
+ * "---" and "+++" (or "***" and "---") lines that is not preceded by one.
+ * The header of a section is open until its first hunk. The lines of a
+ * hunk are never taken for a header: a unified hunk is as long as its
+ * "@@" line says, a context hunk goes on while its lines are marked and
+ * its range lines do not begin a section either.
+ */
+class KompareDiffScanner
+{
+public:
+    enum Boundary {
+        NoBoundary,
+        AtLine,         // a section begins with the line
+        AtPreviousLine  // it begins with the line before
+    };
+
+    KompareDiffScanner();
+
+    /** Looks at the next line of the diff, without its line feed */
+    Boundary addLine(const char* line, qint64 length);
+
+private:
+    enum HeaderLine { OtherLine, MinusLine, StarLine };
+
+    bool        m_headerOpen;
+    bool        m_contextHunk;
+    // the lines of the unified hunk that are still to come
+    qint64      m_sourceLines;
+    qint64      m_destinationLines;
+    // whether the line before could begin a pair of header lines
+    HeaderLine  m_previous;
+};
+
+#endif
@@ -0,0 +1,92 @@
+/***************************************************************************
+                                kompareheightindex.cpp
+                                ----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "kompareheightindex.h"
+
+KompareHeightIndex::KompareHeightIndex() :
+    m_total(0),
+    m_topBit(0)
+{
+}
+
+void KompareHeightIndex::reset(const QVector<qint64>& heights)
+{
+    const int n = heights.size();
+    m_heights = heights;
+    m_tree.fill(0, n + 1);
+    m_total = 0;
+
+    for (int k = 1; k <= n; ++k) {
+        m_tree[k] += heights[k - 1];
+        m_total += heights[k - 1];
+        int parent = k + (k & -k);
+        if (parent <= n)
+            m_tree[parent] += m_tree[k];
+    }
+
+    m_topBit = 1;
+    while (m_topBit * 2 <= n)
+        m_topBit *= 2;
+}
+
+void KompareHeightIndex::clear()
+{
+    m_heights.clear();
+    m_tree.clear();
+    m_total = 0;
+    m_topBit = 0;
+}
+
+qint64 KompareHeightIndex::offset(int i) const
+{
+    qint64 sum = 0;
+    for (int k = i; k > 0; k -= k & -k)
+        sum += m_tree[k];
+    return sum;
+}
+
+void KompareHeightIndex::setHeight(int i, qint64 height)
+{
+    const qint64 delta = height - m_heights[i];
+    if (!delta)
+        return;
+
+    m_heights[i] = height;
+    m_total += delta;
+    const int n = m_heights.size();
+    for (int k = i + 1; k <= n; k += k & -k)
+        m_tree[k] += delta;
+}
+
+int KompareHeightIndex::indexAt(qint64 pos) const
+{
+    // a leading zero height item does not cover anything above the first line either
+    if (pos < 0)
+        pos = 0;
+    if (pos >= m_total)
+        return m_heights.size();
+
+    // the number of leading items that end at or above pos
+    const int n = m_heights.size();
+    int k = 0;
+    for (int step = m_topBit; step; step /= 2) {
+        if (k + step <= n && m_tree[k + step] <= pos) {
+            k += step;
+            pos -= m_tree[k];
+        }
+    }
+    return k;
+}
@@ -0,0 +1,62 @@
+/***************************************************************************
+                                kompareheightindex.h
+                                --------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPAREHEIGHTINDEX_H
+#define KOMPAREHEIGHTINDEX_H
+
+#include <QVector>
+
+/**
+ * Cumulative heights of a list of items, kept in a binary indexed tree.
+ *
+ * The offset of an item, the item covering a position and changing the
+ * height of one item all take O(log n), so applying a difference does not
+ * relayout everything that follows it.
+ *
+ * Heights and sums are 64-bit, tens of millions of lines are taller than an int.
+ *
+ * offset() also works for negative values, the list view uses that to keep
+ * the line number shift of every difference.
+ */
+class KompareHeightIndex
+{
+public:
+    KompareHeightIndex();
+
+    void reset(const QVector<qint64>& heights);
+    void clear();
+
+    int    count() const { return m_heights.size(); };
+    qint64 total() const { return m_total; };
+    qint64 height(int i) const { return m_heights[i]; };
+
+    /** Sum of the heights of the items before item i */
+    qint64 offset(int i) const;
+    void   setHeight(int i, qint64 height);
+    /**
+     * The item covering pos, zero height items are skipped. A negative pos
+     * counts as 0, count() is returned when pos is past the end.
+     */
+    int    indexAt(qint64 pos) const;
+
+private:
+    QVector<qint64> m_heights;
+    QVector<qint64> m_tree;    // 1-based, m_tree[k] holds the sum of the (k & -k) items ending at k
+    qint64          m_total;
+    int             m_topBit;
+};
+
+#endif
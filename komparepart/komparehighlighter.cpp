@@ -0,0 +1,374 @@
+/***************************************************************************
+                                komparehighlighter.cpp
+                                ----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparehighlighter.h"
+
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QtConcurrent>
+
+#include <KSyntaxHighlighting/AbstractHighlighter>
+#include <KSyntaxHighlighting/Definition>
+#include <KSyntaxHighlighting/Format>
+#include <KSyntaxHighlighting/Repository>
+#include <KSyntaxHighlighting/State>
+#include <KSyntaxHighlighting/Theme>
+
+#include <libkomparediff2/diffhunk.h>
+#include <libkomparediff2/diffmodel.h>
+#include <libkomparediff2/difference.h>
+
+#include <komparerenderdebug.h>
+#include "viewsettings.h"
+
+// a batch ends at the first difference boundary after this many lines
+#define BATCH_LINES 2000
+// highlighted lines kept for the models selected last
+#define CACHED_LINES 500000
+
+using namespace Diff2;
+
+/**
+ * Highlights the lines of one side, collecting the colored spans.
+ */
+class KompareSyntaxHighlighter : public KSyntaxHighlighting::AbstractHighlighter
+{
+public:
+    // true when there is a definition for fileName
+    bool setFile(const KSyntaxHighlighting::Repository& repository, const QString& fileName)
+    {
+        if (fileName != m_fileName || !theme().isValid()) {
+            m_fileName = fileName;
+            setDefinition(repository.definitionForFileName(fileName));
+            // the panes are painted on white and the light difference colors
+            setTheme(repository.defaultTheme(KSyntaxHighlighting::Repository::LightTheme));
+        }
+        return definition().isValid();
+    }
+
+    KSyntaxHighlighting::State highlight(const QString& text, const KSyntaxHighlighting::State& state, KompareHighlightSpans& spans)
+    {
+        m_spans = &spans;
+        const KSyntaxHighlighting::State next = highlightLine(text, state);
+        m_spans = nullptr;
+        return next;
+    }
+
+protected:
+    void applyFormat(int offset, int length, const KSyntaxHighlighting::Format& format) override
+    {
+        if (length > 0 && format.hasTextColor(theme()))
+            m_spans->append({ offset, length, format.textColor(theme()) });
+    }
+
+private:
+    QString                m_fileName;
+    KompareHighlightSpans* m_spans = nullptr;
+};
+
+struct KompareHighlightContext
+{
+    QScopedPointer<KSyntaxHighlighting::Repository> repository; // loading it takes a while, done by the first batch
+    KompareSyntaxHighlighter                        source;
+    KompareSyntaxHighlighter                        destination;
+};
+
+// The lines of a difference, copied from the model, the keys are never dereferenced off the GUI thread
+struct KompareHighlightDifference
+{
+    bool                                    unchanged;
+    QVector<const DifferenceString*>        sourceLines;
+    QVector<QString>                        sourceTexts;
+    QVector<const DifferenceString*>        destinationLines;
+    QVector<QString>                        destinationTexts;
+};
+
+// Where highlighting of a hunk goes on
+struct KompareHighlightCheckpoint
+{
+    int                                     difference;
+    KSyntaxHighlighting::State              source;
+    KSyntaxHighlighting::State              destination;
+};
+
+struct KompareHighlightModel
+{
+    QString                                                 sourceFile;
+    QString                                                 destinationFile;
+    QVector<const DiffHunk*>                                hunks;
+    QVector<KompareHighlightCheckpoint>                     checkpoints;
+    QHash<const DiffHunk*, int>                             hunkIndex;
+    QHash<const DifferenceString*, KompareHighlightSpans>   spans;
+    int                                                     remaining;   // hunks not done
+    qint64                                                  time;        // spent highlighting, in nanoseconds
+};
+
+struct KompareHighlightBatch
+{
+    QSharedPointer<KompareHighlightContext>     context;
+    QVector<KompareHighlightDifference>         differences; // from the checkpoint on
+    QString                                     sourceFile;
+    QString                                     destinationFile;
+    KompareHighlightCheckpoint                  checkpoint;
+    const DiffModel*                            model;
+    int                                         hunkIndex;
+    int                                         generation;
+};
+
+struct KompareHighlightResult
+{
+    const DiffModel*                                                model;
+    int                                                             hunkIndex;
+    int                                                             generation;
+    bool                                                            highlighted; // false without a definition for either file
+    KompareHighlightCheckpoint                                      checkpoint;
+    QVector<QPair<const DifferenceString*, KompareHighlightSpans> > lines;
+    qint64                                                          time;
+};
+
+static KompareHighlightResultPointer highlightBatch(const KompareHighlightBatch& batch)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    KompareHighlightResultPointer result(new KompareHighlightResult);
+    result->model = batch.model;
+    result->hunkIndex = batch.hunkIndex;
+    result->generation = batch.generation;
+
+    KompareHighlightContext& context = *batch.context;
+    if (!context.repository)
+        context.repository.reset(new KSyntaxHighlighting::Repository);
+    const bool source = context.source.setFile(*context.repository, batch.sourceFile);
+    const bool destination = context.destination.setFile(*context.repository, batch.destinationFile);
+    const bool shared = source && destination && context.source.definition() == context.destination.definition();
+    result->highlighted = source || destination;
+
+    KompareHighlightCheckpoint checkpoint = batch.checkpoint;
+    for (int i = 0; result->highlighted && i < batch.differences.size(); ++i, ++checkpoint.difference) {
+        const KompareHighlightDifference& diff = batch.differences[i];
+        const KSyntaxHighlighting::State sourceBefore = checkpoint.source;
+        const int firstSourceLine = result->lines.size();
+
+        if (source) {
+            for (int i = 0; i < diff.sourceLines.size(); ++i) {
+                KompareHighlightSpans spans;
+                checkpoint.source = context.source.highlight(diff.sourceTexts[i], checkpoint.source, spans);
+                result->lines.append(qMakePair(diff.sourceLines[i], spans));
+            }
+        }
+
+        if (destination) {
+            if (diff.unchanged && shared && checkpoint.destination == sourceBefore) {
+                // the same lines in the same state, the source side already did the work
+                for (int i = 0; i < diff.destinationLines.size(); ++i)
+                    result->lines.append(qMakePair(diff.destinationLines[i], result->lines[firstSourceLine + i].second));
+                checkpoint.destination = checkpoint.source;
+            } else {
+                for (int i = 0; i < diff.destinationLines.size(); ++i) {
+                    KompareHighlightSpans spans;
+                    checkpoint.destination = context.destination.highlight(diff.destinationTexts[i], checkpoint.destination, spans);
+                    result->lines.append(qMakePair(diff.destinationLines[i], spans));
+                }
+            }
+        }
+    }
+
+    result->checkpoint = checkpoint;
+    result->time = timer.nsecsElapsed();
+    return result;
+}
+
+// The hunks only, their lines are copied batch by batch
+static KompareHighlightModel* snapshotModel(const DiffModel* model)
+{
+    KompareHighlightModel* snapshot = new KompareHighlightModel;
+    snapshot->sourceFile = model->sourceFile();
+    snapshot->destinationFile = model->destinationFile();
+    snapshot->remaining = 0;
+    snapshot->time = 0;
+
+    DiffHunkListConstIterator hunkIt = model->hunks()->begin();
+    DiffHunkListConstIterator hEnd   = model->hunks()->end();
+    for (; hunkIt != hEnd; ++hunkIt)
+    {
+        snapshot->hunkIndex.insert(*hunkIt, snapshot->hunks.size());
+        snapshot->hunks.append(*hunkIt);
+        // the text between hunks is not in the diff, every hunk starts over
+        snapshot->checkpoints.append({ 0, KSyntaxHighlighting::State(), KSyntaxHighlighting::State() });
+        if (!(*hunkIt)->differences().isEmpty())
+            ++snapshot->remaining;
+    }
+
+    return snapshot;
+}
+
+// Only the strings are copied, they share their data with the model
+static void snapshotDifferences(const DiffHunk* hunk, int first, QVector<KompareHighlightDifference>& differences)
+{
+    const DifferenceList list = hunk->differences();
+    int lines = 0;
+    for (int d = first; d < list.size() && lines < BATCH_LINES; ++d)
+    {
+        const Difference* diff = list.at(d);
+        KompareHighlightDifference copy;
+        copy.unchanged = diff->type() == Difference::Unchanged;
+        for (int i = 0; i < diff->sourceLineCount(); ++i) {
+            copy.sourceLines.append(diff->sourceLineAt(i));
+            copy.sourceTexts.append(diff->sourceLineAt(i)->string());
+        }
+        for (int i = 0; i < diff->destinationLineCount(); ++i) {
+            copy.destinationLines.append(diff->destinationLineAt(i));
+            copy.destinationTexts.append(diff->destinationLineAt(i)->string());
+        }
+        differences.append(copy);
+        lines += diff->sourceLineCount() + diff->destinationLineCount();
+    }
+}
+
+KompareHighlighter::KompareHighlighter(ViewSettings* settings, QObject* parent) :
+    QObject(parent),
+    m_settings(settings),
+    m_model(nullptr),
+    m_visibleHunk(0),
+    m_generation(0),
+    m_models(CACHED_LINES),
+    m_context(new KompareHighlightContext)
+{
+    connect(&m_watcher, &QFutureWatcherBase::finished, this, &KompareHighlighter::slotBatchFinished);
+}
+
+KompareHighlighter::~KompareHighlighter()
+{
+    m_watcher.waitForFinished();
+}
+
+void KompareHighlighter::setModel(const DiffModel* model)
+{
+    m_model = model;
+    m_visibleHunk = 0;
+    if (m_model && m_settings->m_syntaxHighlighting && !m_models.contains(m_model))
+        cacheModel(m_model, snapshotModel(m_model));
+    startBatch();
+}
+
+void KompareHighlighter::setVisibleHunk(const DiffHunk* hunk)
+{
+    const KompareHighlightModel* model = m_models.object(m_model);
+    if (model)
+        m_visibleHunk = model->hunkIndex.value(hunk, 0);
+}
+
+bool KompareHighlighter::spans(const DifferenceString* text, KompareHighlightSpans& spans) const
+{
+    const KompareHighlightModel* model = m_models.object(m_model);
+    if (!model)
+        return false;
+    QHash<const DifferenceString*, KompareHighlightSpans>::ConstIterator it = model->spans.constFind(text);
+    if (it == model->spans.constEnd())
+        return false;
+    spans = *it;
+    return true;
+}
+
+void KompareHighlighter::startBatch()
+{
+    // one batch at a time, the next one starts when it finishes
+    if (m_watcher.isRunning())
+        return;
+
+    const KompareHighlightModel* model = m_models.object(m_model);
+    if (!model || !model->remaining)
+        return;
+
+    // the shown hunk first, then the ones below it
+    const int count = model->hunks.size();
+    int hunk = m_visibleHunk;
+    while (model->checkpoints[hunk].difference >= model->hunks[hunk]->differences().size())
+        hunk = (hunk + 1) % count;
+
+    KompareHighlightBatch batch;
+    batch.context = m_context;
+    snapshotDifferences(model->hunks[hunk], model->checkpoints[hunk].difference, batch.differences);
+    batch.sourceFile = model->sourceFile;
+    batch.destinationFile = model->destinationFile;
+    batch.checkpoint = model->checkpoints[hunk];
+    batch.model = m_model;
+    batch.hunkIndex = hunk;
+    batch.generation = m_generation;
+    m_watcher.setFuture(QtConcurrent::run(highlightBatch, batch));
+}
+
+void KompareHighlighter::slotBatchFinished()
+{
+    const KompareHighlightResultPointer result = m_watcher.result();
+    KompareHighlightModel* model = m_models.object(result->model);
+
+    // results from before the settings, the models or the selection changed are
+    // stale, a model that is not shown must not push the shown one out of the cache
+    if (result->generation == m_generation && result->model == m_model && model) {
+        model->time += result->time;
+        if (!result->highlighted) {
+            // there is no definition for the files, nothing to do
+            qCDebug(KOMPARERENDER) << "No syntax definition for" << model->sourceFile << "or" << model->destinationFile;
+            for (int i = 0; i < model->hunks.size(); ++i)
+                model->checkpoints[i].difference = model->hunks[i]->differences().size();
+            model->remaining = 0;
+        } else {
+            for (const auto& line : qAsConst(result->lines))
+                model->spans.insert(line.first, line.second);
+            // the cost grows with the spans
+            cacheModel(result->model, m_models.take(result->model));
+
+            const DiffHunk* hunk = model->hunks[result->hunkIndex];
+            model->checkpoints[result->hunkIndex] = result->checkpoint;
+            if (result->checkpoint.difference >= hunk->differences().size() && --model->remaining == 0)
+                qCDebug(KOMPARERENDER) << "Highlighted" << model->destinationFile << "in" << model->time / 1000000 << "ms";
+            if (!result->lines.isEmpty())
+                emit hunkHighlighted(hunk);
+        }
+    }
+
+    startBatch();
+}
+
+void KompareHighlighter::cacheModel(const DiffModel* key, KompareHighlightModel* model)
+{
+    // a model larger than the cache pushes out all others, but is kept
+    m_models.insert(key, model, qMin(model->spans.size(), m_models.maxCost()));
+}
+
+void KompareHighlighter::clear()
+{
+    // a running batch finishes, its results are dropped
+    ++m_generation;
+    m_models.clear();
+    m_visibleHunk = 0;
+}
+
+void KompareHighlighter::slotModelsChanged()
+{
+    clear();
+    m_model = nullptr;
+    emit reset();
+}
+
+void KompareHighlighter::slotConfigChanged()
+{
+    clear();
+    emit reset();
+    setModel(m_model);
+}
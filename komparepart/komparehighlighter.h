@@ -0,0 +1,107 @@
+/***************************************************************************
+                                komparehighlighter.h
+                                --------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPAREHIGHLIGHTER_H
+#define KOMPAREHIGHLIGHTER_H
+
+#include <QCache>
+#include <QColor>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+
+namespace Diff2 {
+class DiffHunk;
+class DiffModel;
+class DifferenceString;
+}
+
+class ViewSettings;
+
+/** A colored piece of a line, offset and length in characters of the line */
+struct KompareHighlightSpan
+{
+    int    offset;
+    int    length;
+    QColor color;
+};
+
+typedef QVector<KompareHighlightSpan> KompareHighlightSpans;
+
+struct KompareHighlightContext;
+struct KompareHighlightModel;
+struct KompareHighlightResult;
+
+typedef QSharedPointer<KompareHighlightResult> KompareHighlightResultPointer;
+
+/**
+ * Syntax highlighting of the lines of the selected model, shared by both panes.
+ *
+ * The hunks are highlighted on a worker thread, one batch of lines at a
+ * time, beginning with the hunk that is shown. A hunk is highlighted from
+ * its first line on, the state between batches is kept as a checkpoint.
+ * Unchanged lines are highlighted once when both sides reach them in the
+ * same state. Only the lines of a batch are copied from the model, just
+ * before it starts. Results are kept per line for the models selected last,
+ * up to a number of lines, and dropped when the models or the settings
+ * change.
+ */
+class KompareHighlighter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KompareHighlighter(ViewSettings* settings, QObject* parent = nullptr);
+    ~KompareHighlighter() override;
+
+    void setModel(const Diff2::DiffModel* model);
+    /** The hunk at the top of a pane, highlighting goes on from there */
+    void setVisibleHunk(const Diff2::DiffHunk* hunk);
+    /** False while text is not highlighted yet */
+    bool spans(const Diff2::DifferenceString* text, KompareHighlightSpans& spans) const;
+
+public Q_SLOTS:
+    void slotModelsChanged();
+    void slotConfigChanged();
+
+Q_SIGNALS:
+    /** More lines of hunk are highlighted */
+    void hunkHighlighted(const Diff2::DiffHunk* hunk);
+    /** Everything highlighted so far was dropped */
+    void reset();
+
+private Q_SLOTS:
+    void slotBatchFinished();
+
+private:
+    void startBatch();
+    void cacheModel(const Diff2::DiffModel* key, KompareHighlightModel* model);
+    void clear();
+
+    ViewSettings*                                                    m_settings;
+    const Diff2::DiffModel*                                          m_model;
+    int                                                              m_visibleHunk;
+    int                                                              m_generation;
+    // Cost in highlighted lines, the spans of a model go with it
+    QCache<const Diff2::DiffModel*, KompareHighlightModel>           m_models;
+    // the syntax definitions, only ever used by the one batch that runs
+    QSharedPointer<KompareHighlightContext>                          m_context;
+    QFutureWatcher<KompareHighlightResultPointer>                    m_watcher;
+};
+
+#endif
@@ -19,15 +19,19 @@
 
 #include "komparelistview.h"
 
+#include <algorithm>
+
 #include <QStyle>
+#include <QFontInfo>
+#include <QFontMetrics>
 #include <QPainter>
-#include <QRegExp>
-#include <QTimer>
 #include <QResizeEvent>
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <QScrollBar>
 
+#include <QtConcurrentRun>
+
 #include <KSharedConfig>
 
 #include <libkomparediff2/diffmodel.h>
@@ -36,19 +40,39 @@
 #include <libkomparediff2/komparemodellist.h>
 
 #include <komparepartdebug.h>
+#include <komparerenderdebug.h>
+#include "komparehighlighter.h"
 #include "viewsettings.h"
 #include "komparesplitter.h"
-
-#define COL_LINE_NO      0
-#define COL_MAIN         1
+#include "komparetilerenderer.h"
+#include "kompareoverviewruler.h"
 
 #define BLANK_LINE_HEIGHT 3
 #define HUNK_LINE_HEIGHT  5
 
 #define ITEM_MARGIN 3
 
+#define SEGMENT_LENGTH 256
+
+#define TILE_HEIGHT    256
+#define TILE_WIDTH     512
+#define PREFETCH_TILES 2
+
+// itemRect() clamps to this, the connectors clamp further for X11 anyway
+#define ITEM_RECT_LIMIT (1 << 30)
+
 using namespace Diff2;
 
+static quint64 tileKey(int band, int column)
+{
+    return (quint64(quint32(band)) << 32) | quint32(column);
+}
+
+static int tileBand(quint64 key)
+{
+    return int(key >> 32);
+}
+
 KompareListViewFrame::KompareListViewFrame(bool isSource,
                                            ViewSettings* settings,
                                            KompareSplitter* parent,
@@ -78,6 +102,8 @@ KompareListViewFrame::KompareListViewFrame(bool isSource,
     connect(parent, &KompareSplitter::scrollViewsToId, &m_view, &KompareListView::scrollToId);
     connect(parent, &KompareSplitter::setXOffset, &m_view, &KompareListView::setXOffset);
     connect(&m_view, &KompareListView::resized, parent, &KompareSplitter::slotUpdateScrollBars);
+    m_view.setScrollGeometry(parent->scrollGeometry());
+    m_view.setHighlighter(parent->highlighter());
 }
 
 void KompareListViewFrame::slotSetModel(const DiffModel* model)
@@ -103,27 +129,46 @@ void KompareListViewFrame::slotSetModel(const DiffModel* model)
 KompareListView::KompareListView(bool isSource,
                                  ViewSettings* settings,
                                  QWidget* parent, const char* name) :
-    QTreeWidget(parent),
+    QAbstractScrollArea(parent),
     m_isSource(isSource),
+    m_scrollGeometry(nullptr),
+    m_highlighter(nullptr),
     m_settings(settings),
     m_scrollId(-1),
+    m_contentsY(0),
+    m_lineHeight(1),
+    m_lineNumberWidth(0),
+    m_maxMainWidth(0),
+    m_columnTabWidth(-1),
     m_selectedModel(nullptr),
-    m_selectedDifference(nullptr)
+    m_selectedDifference(nullptr),
+    m_lineLayouts(1 << 20),
+    m_layoutTabWidth(-1),
+    m_layoutFixedPitch(false),
+    m_layoutCharWidth(0),
+    m_layoutBoldCharWidth(0),
+    m_layoutHits(0),
+    m_layoutMisses(0),
+    m_paneStates(16 * 1024),
+    m_widthModel(nullptr),
+    m_widthBase(0),
+    m_tiles(32 * 1024),
+    m_tileDevicePixelRatio(0),
+    m_tileHits(0),
+    m_tileMisses(0),
+    m_tilesPrefetched(0),
+    m_tileRenderTime(0)
 {
     setObjectName(QLatin1String(name));
-    setItemDelegate(new KompareListViewItemDelegate(this));
-    setHeaderHidden(true);
-    setColumnCount(3);   // Line Number, Main, Blank
-    setAllColumnsShowFocus(true);
-    setRootIsDecorated(false);
-    setIndentation(0);
     setFrameStyle(QFrame::NoFrame);
-    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
     setFocusPolicy(Qt::NoFocus);
     setFont(m_settings->m_font);
+    m_lineHeight = fontMetrics().height();
     setFocusProxy(parent->parentWidget());
+    connect(&m_widthWatcher, &QFutureWatcher<int>::finished, this, &KompareListView::slotWidthMeasured);
 }
 
 KompareListView::~KompareListView()
@@ -133,80 +178,174 @@ KompareListView::~KompareListView()
     m_selectedDifference = nullptr;
 }
 
-KompareListViewItem* KompareListView::itemAtIndex(int i)
+static int textWidth(const QFontMetrics& fm, const QString& text)
 {
-    return m_items[ i ];
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    return fm.horizontalAdvance(text);
+#else
+    return fm.width(text);
+#endif
 }
 
-int KompareListView::firstVisibleDifference()
+// Expands the tabs in text in a single pass. column is the display column
+// the text starts at and is moved past its end. narrow is cleared when the
+// text contains characters that may not take exactly one column.
+static QString expandTabs(const QString& text, int tabstop, int& column, bool& narrow)
 {
-    QTreeWidgetItem* item = itemAt(QPoint(0, 0));
+    const int length = text.length();
+    const QChar* data = text.constData();
+    narrow = true;
 
-    if (item == nullptr)
-    {
-        qCDebug(KOMPAREPART) << "no item at viewport coordinates (0,0)" ;
+    int tab = text.indexOf(QLatin1Char('\t'));
+    if (tab == -1) {
+        for (int i = 0; i < length && narrow; ++i)
+            narrow = data[i].unicode() < 0x0300;
+        column += length;
+        return text;
     }
 
-    while (item) {
-        KompareListViewLineItem* lineItem = dynamic_cast<KompareListViewLineItem*>(item);
-        if (lineItem && lineItem->diffItemParent()->difference()->type() != Difference::Unchanged)
-            break;
-        item = itemBelow(item);
+    QString result;
+    result.reserve(length + 8 * tabstop);
+    result.append(data, tab);
+    column += tab;
+    for (int i = 0; i < tab && narrow; ++i)
+        narrow = data[i].unicode() < 0x0300;
+
+    for (int i = tab; i < length; ++i) {
+        const QChar c = data[i];
+        if (c == QLatin1Char('\t')) {
+            const int spaces = tabstop - column % tabstop;
+            result.resize(result.length() + spaces, QLatin1Char(' '));
+            column += spaces;
+        } else {
+            narrow = narrow && c.unicode() < 0x0300;
+            result.append(c);
+            ++column;
+        }
     }
+    return result;
+}
+
+// The number of display columns of text, see expandTabs()
+static int displayColumns(const QString& text, int tabstop, bool& narrow)
+{
+    const int length = text.length();
+    const QChar* data = text.constData();
+    int column = 0;
+    narrow = true;
+
+    for (int i = 0; i < length; ++i) {
+        const QChar c = data[i];
+        if (c == QLatin1Char('\t')) {
+            column += tabstop - column % tabstop;
+        } else {
+            narrow = narrow && c.unicode() < 0x0300;
+            ++column;
+        }
+    }
+    return column;
+}
+
+// The width of the widest of lines, run on a worker thread
+static int measureWidestLine(const QVector<QString>& lines, const QFont& font, int tabstop)
+{
+    const QFontMetrics fm(font);
+    int maxWidth = 0;
+
+    for (const QString& line : lines) {
+        int column = 0;
+        bool narrow;
+        maxWidth = qMax(maxWidth, textWidth(fm, expandTabs(line, tabstop, column, narrow)));
+    }
+    return maxWidth;
+}
+
+int KompareListView::blockAt(qint64 y) const
+{
+    return m_heightIndex.indexAt(y);
+}
 
-    if (item)
-        return m_items.indexOf(((KompareListViewLineItem*)item)->diffItemParent());
+int KompareListView::firstVisibleDifference()
+{
+    int i = blockAt(contentsY());
 
-    return -1;
+    if (i == m_blocks.size())
+    {
+        qCDebug(KOMPAREPART) << "no item at viewport coordinates (0,0)" ;
+        return -1;
+    }
+
+    // the first difference at or below the top
+    const int change = m_blocks[i].change;
+    return change < m_items.size() ? change : -1;
 }
 
 int KompareListView::lastVisibleDifference()
 {
-    QTreeWidgetItem* item = itemAt(QPoint(0, visibleHeight() - 1));
+    int i = blockAt(contentsY() + visibleHeight() - 1);
 
-    if (item == nullptr)
+    if (i == m_blocks.size())
     {
         qCDebug(KOMPAREPART) << "no item at viewport coordinates (0," << visibleHeight() - 1 << ")" ;
-        // find last item
-        item = itemAt(QPoint(0, 0));
-        if (item) {
-            QTreeWidgetItem* nextItem = item;
-            do {
-                item = nextItem;
-                nextItem = itemBelow(item);
-            } while (nextItem);
-        }
+        // the last item
+        return m_items.size() - 1;
     }
 
-    while (item) {
-        KompareListViewLineItem* lineItem = dynamic_cast<KompareListViewLineItem*>(item);
-        if (lineItem && lineItem->diffItemParent()->difference()->type() != Difference::Unchanged)
-            break;
-        item = itemAbove(item);
-    }
+    // the last difference at or above the bottom
+    const Block& block = m_blocks[i];
+    const bool changed = block.type == Block::Diff && block.difference->type() != Difference::Unchanged;
+    return changed ? block.change : block.change - 1;
+}
+
+QRect KompareListView::itemRect(int i)
+{
+    return blockRect(m_items[i]);
+}
 
-    if (item)
-        return m_items.indexOf(((KompareListViewLineItem*)item)->diffItemParent());
+QRect KompareListView::differenceRect(const Difference* diff)
+{
+    QHash<const Difference*, int>::ConstIterator it = m_itemDict.constFind(diff);
+    return it == m_itemDict.constEnd() ? QRect() : blockRect(*it);
+}
 
-    return -1;
+QRect KompareListView::blockRect(int i)
+{
+    const Block& block = m_blocks[i];
+    // far off screen coordinates are clamped, they do not fit in an int
+    const qint64 top = m_heightIndex.offset(i) - contentsY();
+    const qint64 bottom = top + block.height - 1;
+    return QRect(QPoint(0, int(qBound<qint64>(-ITEM_RECT_LIMIT, top, ITEM_RECT_LIMIT))),
+                 QPoint(visibleWidth() - 1, int(qBound<qint64>(-ITEM_RECT_LIMIT, bottom, ITEM_RECT_LIMIT))));
 }
 
-QRect KompareListView::totalVisualItemRect(QTreeWidgetItem* item)
+QVector<KompareOverviewEntry> KompareListView::overviewEntries() const
 {
-    QRect total = visualItemRect(item);
-    int n = item->childCount();
-    for (int i = 0; i < n; ++i) {
-        QTreeWidgetItem* child = item->child(i);
-        if (!child->isHidden())
-            total = total.united(totalVisualItemRect(child));
+    QVector<KompareOverviewEntry> entries;
+    entries.reserve(m_items.size());
+    for (int i : m_items) {
+        const Block& block = m_blocks[i];
+        entries.append({ block.difference, block.scrollId, block.maxHeight, KompareOverviewRuler::category(block.difference) });
     }
-    return total;
+    return entries;
 }
 
-QRect KompareListView::itemRect(int i)
+qint64 KompareListView::scrollHeight() const
 {
-    QTreeWidgetItem* item = itemAtIndex(i);
-    return totalVisualItemRect(item);
+    if (m_blocks.isEmpty())
+        return 0;
+    const Block& block = m_blocks.last();
+    return block.scrollId + block.maxHeight;
+}
+
+qint64 KompareListView::lineScrollId(const Difference* diff, int line) const
+{
+    QHash<const Difference*, int>::ConstIterator it = m_itemDict.constFind(diff);
+    if (it == m_itemDict.constEnd())
+        return -1;
+
+    const Block& block = m_blocks[*it];
+    const int lines = qMax(1, lineCount(block));
+    return block.scrollId + qint64((qBound(0, line, lines - 1) + 0.5) * block.maxHeight / lines);
 }
 
 int KompareListView::minScrollId()
@@ -214,24 +353,21 @@ int KompareListView::minScrollId()
     return visibleHeight() / 2;
 }
 
-int KompareListView::maxScrollId()
+qint64 KompareListView::maxScrollId()
 {
-    int n = topLevelItemCount();
-    if (!n) return 0;
-    KompareListViewItem* item = (KompareListViewItem*)topLevelItem(n - 1);
-    int maxId = item->scrollId() + item->maxHeight() - minScrollId();
-    qCDebug(KOMPAREPART) << "Max ID = " << maxId ;
-    return maxId;
+    if (m_blocks.isEmpty()) return 0;
+    const Block& block = m_blocks.last();
+    return block.scrollId + block.maxHeight - minScrollId();
 }
 
-int KompareListView::contentsHeight()
+qint64 KompareListView::contentsHeight()
 {
-    return verticalScrollBar()->maximum() + viewport()->height() - style()->pixelMetric(QStyle::PM_ScrollBarExtent);
+    return qMax<qint64>(m_heightIndex.total(), viewport()->height()) - style()->pixelMetric(QStyle::PM_ScrollBarExtent);
 }
 
 int KompareListView::contentsWidth()
 {
-    return (columnWidth(COL_LINE_NO) + columnWidth(COL_MAIN));
+    return (m_lineNumberWidth + m_maxMainWidth);
 }
 
 int KompareListView::visibleHeight()
@@ -246,22 +382,26 @@ int KompareListView::visibleWidth()
 
 int KompareListView::contentsX()
 {
-    return horizontalOffset();
+    return horizontalScrollBar()->value();
 }
 
-int KompareListView::contentsY()
+qint64 KompareListView::contentsY()
 {
-    return verticalOffset();
+    return m_contentsY;
 }
 
-int KompareListView::nextPaintOffset() const
+void KompareListView::setContentsY(qint64 y)
 {
-    return m_nextPaintOffset;
-}
+    y = qBound<qint64>(0, y, qMax<qint64>(0, m_heightIndex.total() - viewport()->height()));
+    const qint64 dy = m_contentsY - y;
+    if (!dy)
+        return;
 
-void KompareListView::setNextPaintOffset(int offset)
-{
-    m_nextPaintOffset = offset;
+    m_contentsY = y;
+    if (qAbs(dy) < viewport()->height())
+        viewport()->scroll(0, int(dy));
+    else
+        viewport()->update();
 }
 
 void KompareListView::setXOffset(int x)
@@ -270,44 +410,26 @@ void KompareListView::setXOffset(int x)
     horizontalScrollBar()->setValue(x);
 }
 
-void KompareListView::scrollToId(int id)
+void KompareListView::scrollToId(qint64 id)
 {
 //     qCDebug(KOMPAREPART) << "ScrollToID : Scroll to id : " << id ;
-    int n = topLevelItemCount();
-    KompareListViewItem* item = nullptr;
-    if (n) {
-        int i = 1;
-        for (; i < n; ++i) {
-            if (((KompareListViewItem*)topLevelItem(i))->scrollId() > id)
-                break;
-        }
-        item = (KompareListViewItem*)topLevelItem(i - 1);
-    }
-
-    if (item) {
-        QRect rect = totalVisualItemRect(item);
-        int pos = rect.top() + verticalOffset();
-        int itemId = item->scrollId();
-        int height = rect.height();
-        double r = (double)(id - itemId) / (double)item->maxHeight();
-        int y = pos + (int)(r * (double)height) - minScrollId();
-//         qCDebug(KOMPAREPART) << "scrollToID: " ;
-//         qCDebug(KOMPAREPART) << "            id = " << id ;
-//         qCDebug(KOMPAREPART) << "           pos = " << pos ;
-//         qCDebug(KOMPAREPART) << "        itemId = " << itemId ;
-//         qCDebug(KOMPAREPART) << "             r = " << r ;
-//         qCDebug(KOMPAREPART) << "        height = " << height ;
-//         qCDebug(KOMPAREPART) << "         minID = " << minScrollId() ;
-//         qCDebug(KOMPAREPART) << "             y = " << y ;
-//         qCDebug(KOMPAREPART) << "contentsHeight = " << contentsHeight() ;
-//         qCDebug(KOMPAREPART) << "         c - y = " << contentsHeight() - y ;
-        verticalScrollBar()->setValue(y);
+    if (!m_blocks.isEmpty()) {
+        // scroll ids never change after layout, the last block starting at or before id
+        QVector<Block>::const_iterator it = std::upper_bound(m_blocks.constBegin() + 1, m_blocks.constEnd(), id,
+                                                             [](qint64 value, const Block& block) { return value < block.scrollId; });
+        const int i = it - m_blocks.constBegin() - 1;
+        const Block& block = m_blocks[i];
+
+        // zero height hunks have no extent in scroll id space
+        double r = block.maxHeight ? (double)(id - block.scrollId) / (double)block.maxHeight : 0.0;
+        qint64 y = m_heightIndex.offset(i) + (qint64)(r * (double)block.height) - minScrollId();
+        setContentsY(y);
     }
 
     m_scrollId = id;
 }
 
-int KompareListView::scrollId()
+qint64 KompareListView::scrollId()
 {
     if (m_scrollId < 0)
         m_scrollId = minScrollId();
@@ -332,24 +454,55 @@ void KompareListView::setSelectedDifference(const Difference* diff, bool scroll)
     if (m_selectedDifference == diff)
         return;
 
+    // Only the previously and the newly selected difference look different
+    QHash<const Difference*, int>::ConstIterator previous = m_itemDict.constFind(m_selectedDifference);
+    if (previous != m_itemDict.constEnd())
+        invalidateBlock(*previous);
+
     m_selectedDifference = diff;
 
-    KompareListViewItem* item = m_itemDict[ diff ];
-    if (!item) {
+    QHash<const Difference*, int>::ConstIterator it = m_itemDict.constFind(diff);
+    if (it == m_itemDict.constEnd()) {
         qCDebug(KOMPAREPART) << "KompareListView::slotSetSelection(): couldn't find our selection!" ;
         return;
     }
 
+    invalidateBlock(*it);
     // why does this not happen when the user clicks on a diff? see the comment above.
     if (scroll)
-        scrollToId(item->scrollId());
-    setUpdatesEnabled(false);
-    int x = horizontalScrollBar()->value();
-    int y = verticalScrollBar()->value();
-    setCurrentItem(item);
-    horizontalScrollBar()->setValue(x);
-    verticalScrollBar()->setValue(y);
-    setUpdatesEnabled(true);
+        scrollToId(m_blocks[*it].scrollId);
+}
+
+void KompareListView::invalidateBlock(int i)
+{
+    const qint64 top = m_heightIndex.offset(i);
+    invalidateContents(top, top + m_blocks[i].height - 1);
+}
+
+void KompareListView::invalidateContents(qint64 top, qint64 bottom)
+{
+    if (bottom < top)
+        return;
+
+    // a prefetch of a dropped tile is not used when it arrives
+    const int firstBand = int(top / TILE_HEIGHT);
+    const int lastBand = int(bottom / TILE_HEIGHT);
+    const QList<quint64> keys = m_tiles.keys();
+    for (quint64 key : keys) {
+        if (tileBand(key) >= firstBand && tileBand(key) <= lastBand)
+            m_tiles.remove(key);
+    }
+    for (QHash<quint64, QObject*>::Iterator it = m_pendingTiles.begin(); it != m_pendingTiles.end();) {
+        if (tileBand(it.key()) >= firstBand && tileBand(it.key()) <= lastBand)
+            it = m_pendingTiles.erase(it);
+        else
+            ++it;
+    }
+
+    const QRect rect(QPoint(0, int(qBound<qint64>(-ITEM_RECT_LIMIT, top - contentsY(), ITEM_RECT_LIMIT))),
+                     QPoint(visibleWidth() - 1, int(qBound<qint64>(-ITEM_RECT_LIMIT, bottom - contentsY(), ITEM_RECT_LIMIT))));
+    if (rect.intersects(viewport()->rect()))
+        viewport()->update(rect);
 }
 
 void KompareListView::slotSetSelection(const Difference* diff)
@@ -368,613 +521,831 @@ void KompareListView::slotSetSelection(const DiffModel* model, const Difference*
         return;
     }
 
-    clear();
-    m_items.clear();
-    m_itemDict.clear();
+    saveState();
     m_selectedModel = model;
+    m_selectedDifference = nullptr;
 
-    DiffHunkListConstIterator hunkIt = model->hunks()->begin();
-    DiffHunkListConstIterator hEnd   = model->hunks()->end();
-
-    KompareListViewItem* item = nullptr;
-    m_nextPaintOffset = 0;
-
-    for (; hunkIt != hEnd; ++hunkIt)
-    {
-        if (item)
-            item = new KompareListViewHunkItem(this, item, *hunkIt, model->isBlended());
-        else
-            item = new KompareListViewHunkItem(this, *hunkIt, model->isBlended());
-
-        DifferenceListConstIterator diffIt = (*hunkIt)->differences().begin();
-        DifferenceListConstIterator dEnd   = (*hunkIt)->differences().end();
-
-        for (; diffIt != dEnd; ++diffIt)
-        {
-            item = new KompareListViewDiffItem(this, item, *diffIt);
-
-            int type = (*diffIt)->type();
+    if (!restoreState(model)) {
+        buildBlocks(model);
+        qCDebug(KOMPAREPART) << "Layout of" << m_blocks.size() << "blocks uses about" << layoutFootprint() << "bytes";
 
-            if (type != Difference::Unchanged)
-            {
-                m_items.append((KompareListViewDiffItem*)item);
-                m_itemDict.insert(*diffIt, (KompareListViewDiffItem*)item);
-            }
-        }
+        updateColumnWidths();
+        updateScrollBarRanges();
+        setContentsY(0);
     }
-
-    resizeColumnToContents(COL_LINE_NO);
-    resizeColumnToContents(COL_MAIN);
+    invalidateTiles();
+    viewport()->update();
 
     slotSetSelection(diff);
 }
 
-KompareListViewDiffItem* KompareListView::diffItemAt(const QPoint& pos)
+void KompareListView::slotModelsChanged()
 {
-    KompareListViewItem* item = static_cast<KompareListViewItem*>(itemAt(pos));
-    if (!item)
-        return nullptr;
-    switch (item->type()) {
-        case KompareListViewItem::Hunk:
-            if (item->paintHeight()) return nullptr;  // no diff item here
-            // zero height (fake 1 pixel height), so a diff item shines through
-            return static_cast<KompareListViewDiffItem*>(itemBelow(item));
-        case KompareListViewItem::Line:
-        case KompareListViewItem::Blank:
-            return static_cast<KompareListViewLineItem*>(item)->diffItemParent();
-        case KompareListViewItem::Container:
-            return static_cast<KompareListViewLineContainerItem*>(item)->diffItemParent();
-        case KompareListViewItem::Diff:
-            return static_cast<KompareListViewDiffItem*>(item);
-        default:
-            return nullptr;
-    }
+    // The models the cached layouts point into are gone
+    m_paneStates.clear();
+    clearLineLayouts();
+
+    m_selectedModel = nullptr;
+    m_selectedDifference = nullptr;
+    buildBlocks(nullptr);
+    updateColumnWidths();
+    updateScrollBarRanges();
+    invalidateTiles();
+    viewport()->update();
 }
 
-void KompareListView::mousePressEvent(QMouseEvent* e)
+void KompareListView::slotConfigChanged()
 {
-    QPoint vp = e->pos();
-    KompareListViewDiffItem* diffItem = diffItemAt(vp);
-    if (diffItem && diffItem->difference()->type() != Difference::Unchanged) {
-        emit differenceClicked(diffItem->difference());
+    // the colors may have changed as well
+    setFont(m_settings->m_font);
+    // a new font measures the columns again in changeEvent(), a new tab width only here
+    if (m_selectedModel && m_columnTabWidth != m_settings->m_tabToNumberOfSpaces) {
+        updateColumnWidths();
+        updateScrollBarRanges();
+        emit resized();
     }
+    invalidateTiles();
+    viewport()->update();
 }
 
-void KompareListView::mouseDoubleClickEvent(QMouseEvent* e)
+void KompareListView::saveState()
 {
-    QPoint vp = e->pos();
-    KompareListViewDiffItem* diffItem = diffItemAt(vp);
-    if (diffItem && diffItem->difference()->type() != Difference::Unchanged) {
-        // FIXME: make a new signal that does both
-        emit differenceClicked(diffItem->difference());
-        emit applyDifference(!diffItem->difference()->applied());
+    if (!m_selectedModel)
+        return;
+
+    const int cost = layoutFootprint() / 1024 + 1;
+    if (cost > m_paneStates.maxCost())
+        return;
+
+    PaneState* state = new PaneState;
+    state->blocks = std::move(m_blocks);
+    state->items = std::move(m_items);
+    state->itemDict = std::move(m_itemDict);
+    state->hunkDict = std::move(m_hunkDict);
+    state->heightIndex = std::move(m_heightIndex);
+    state->lineShifts = std::move(m_lineShifts);
+    state->lineNumberWidth = m_lineNumberWidth;
+    state->maxMainWidth = m_maxMainWidth;
+    state->tabWidth = m_settings->m_tabToNumberOfSpaces;
+    state->scrollId = m_scrollId;
+    state->y = contentsY();
+    state->widthPending = (m_widthModel == m_selectedModel);
+    m_widthModel = nullptr;
+    m_paneStates.insert(m_selectedModel, state, cost);
+}
+
+bool KompareListView::restoreState(const DiffModel* model)
+{
+    PaneState* state = m_paneStates.take(model);
+    if (!state)
+        return false;
+
+    // the column widths depend on the tab width
+    if (state->tabWidth != m_settings->m_tabToNumberOfSpaces) {
+        delete state;
+        return false;
+    }
+
+    m_blocks = std::move(state->blocks);
+    m_items = std::move(state->items);
+    m_itemDict = std::move(state->itemDict);
+    m_hunkDict = std::move(state->hunkDict);
+    m_heightIndex = std::move(state->heightIndex);
+    m_lineShifts = std::move(state->lineShifts);
+    m_lineNumberWidth = state->lineNumberWidth;
+    m_maxMainWidth = state->maxMainWidth;
+    m_columnTabWidth = state->tabWidth;
+    m_scrollId = state->scrollId;
+    const qint64 y = state->y;
+    const bool widthPending = state->widthPending;
+    delete state;
+
+    // the measurement was dropped when the model was hidden
+    if (widthPending)
+        updateColumnWidths();
+
+    // differences may have been applied while the model was not shown
+    bool changed = false;
+    for (int i : qAsConst(m_items)) {
+        Block& block = m_blocks[i];
+        const qint64 height = block.height;
+        updateBlockHeight(block);
+        changed = changed || block.height != height;
     }
+    if (changed)
+        layoutBlocks();
+
+    qCDebug(KOMPAREPART) << "Restored the layout of" << m_blocks.size() << "blocks";
+    updateScrollBarRanges();
+    setContentsY(y);
+    return true;
 }
 
-void KompareListView::renumberLines()
+void KompareListView::buildBlocks(const DiffModel* model)
 {
-//     qCDebug(KOMPAREPART) << "Begin" ;
-    unsigned int newLineNo = 1;
-    if (!topLevelItemCount()) return;
-    KompareListViewItem* item = (KompareListViewItem*)topLevelItem(0);
-    while (item) {
-//         qCDebug(KOMPAREPART) << "type: " << item->type() ;
-        if (item->type() != KompareListViewItem::Container
-                && item->type() != KompareListViewItem::Blank
-                && item->type() != KompareListViewItem::Hunk)
+    m_blocks.clear();
+    m_items.clear();
+    m_itemDict.clear();
+    m_hunkDict.clear();
+
+    if (!model) {
+        layoutBlocks();
+        return;
+    }
+
+    DiffHunkListConstIterator hunkIt = model->hunks()->begin();
+    DiffHunkListConstIterator hEnd   = model->hunks()->end();
+
+    for (; hunkIt != hEnd; ++hunkIt)
+    {
+        Block hunkBlock = { Block::Hunk, *hunkIt, nullptr, m_items.size(), 0, 0, 0, 0 };
+        updateBlockHeight(hunkBlock);
+        m_hunkDict.insert(*hunkIt, m_blocks.size());
+        m_blocks.append(hunkBlock);
+
+        DifferenceListConstIterator diffIt = (*hunkIt)->differences().begin();
+        DifferenceListConstIterator dEnd   = (*hunkIt)->differences().end();
+
+        for (; diffIt != dEnd; ++diffIt)
         {
-//             qCDebug(KOMPAREPART) << QString::number( newLineNo ) ;
-            item->setText(COL_LINE_NO, QString::number(newLineNo++));
+            Block block = { Block::Diff, *hunkIt, *diffIt, m_items.size(), 0, 0, 0, 0 };
+            updateBlockHeight(block);
+            block.lineNumber = m_isSource ? (*diffIt)->sourceLineNumber()
+                                          : (*diffIt)->destinationLineNumber();
+            m_blocks.append(block);
+            m_itemDict.insert(*diffIt, m_blocks.size() - 1);
+
+            if ((*diffIt)->type() != Difference::Unchanged)
+                m_items.append(m_blocks.size() - 1);
         }
-        item = (KompareListViewItem*)itemBelow(item);
     }
-}
 
-void KompareListView::slotApplyDifference(bool apply)
-{
-    m_itemDict[ m_selectedDifference ]->applyDifference(apply);
-    // now renumber the line column if this is the destination
-    if (!m_isSource)
-        renumberLines();
+    layoutBlocks();
 }
 
-void KompareListView::slotApplyAllDifferences(bool apply)
+bool KompareListView::showsSourceLines(const Block& block) const
 {
-    QHash<const Diff2::Difference*, KompareListViewDiffItem*>::ConstIterator it = m_itemDict.constBegin();
-    QHash<const Diff2::Difference*, KompareListViewDiffItem*>::ConstIterator end = m_itemDict.constEnd();
-    for (; it != end; ++it)
-        it.value()->applyDifference(apply);
-
-    // now renumber the line column if this is the destination
-    if (!m_isSource)
-        renumberLines();
-    update();
+    return m_isSource || block.difference->applied();
 }
 
-void KompareListView::slotApplyDifference(const Difference* diff, bool apply)
+int KompareListView::lineCount(const Block& block) const
 {
-    m_itemDict[ diff ]->applyDifference(apply);
-    // now renumber the line column if this is the destination
-    if (!m_isSource)
-        renumberLines();
+    return showsSourceLines(block) ? block.difference->sourceLineCount()
+                                   : block.difference->destinationLineCount();
 }
 
-void KompareListView::wheelEvent(QWheelEvent* e)
+DifferenceString* KompareListView::lineAt(const Block& block, int i) const
 {
-    e->ignore(); // we want the parent to catch wheel events
+    return showsSourceLines(block) ? block.difference->sourceLineAt(i)
+                                   : block.difference->destinationLineAt(i);
 }
 
-void KompareListView::resizeEvent(QResizeEvent* e)
+int KompareListView::layoutFootprint() const
 {
-    QTreeWidget::resizeEvent(e);
-    emit resized();
+    // An estimate of what the layout itself allocates, from the capacities of
+    // its containers. The text of the lines is never copied, it is read from
+    // the model while painting.
+    return m_blocks.capacity() * sizeof(Block)
+         + m_items.capacity() * sizeof(int)
+         + (m_heightIndex.count() + m_lineShifts.count()) * 2 * sizeof(qint64)
+         + m_itemDict.capacity() * (sizeof(const Difference*) + sizeof(int) + 2 * sizeof(void*))
+         + m_hunkDict.capacity() * (sizeof(const DiffHunk*) + sizeof(int) + 2 * sizeof(void*));
 }
 
-KompareListViewItemDelegate::KompareListViewItemDelegate(QObject* parent)
-    : QStyledItemDelegate(parent)
+void KompareListView::updateBlockHeight(Block& block) const
 {
-}
+    if (block.type == Block::Hunk) {
+        if (m_selectedModel->isBlended())
+            block.maxHeight = 0;
+        else if (block.hunk->function().isEmpty())
+            block.maxHeight = HUNK_LINE_HEIGHT;
+        else
+            block.maxHeight = m_lineHeight;
+        block.height = block.maxHeight;
+        return;
+    }
 
-KompareListViewItemDelegate::~KompareListViewItemDelegate()
-{
+    int lines = qMax(block.difference->sourceLineCount(), block.difference->destinationLineCount());
+    block.maxHeight = lines ? qint64(lines) * m_lineHeight : BLANK_LINE_HEIGHT;
+    lines = lineCount(block);
+    block.height = lines ? qint64(lines) * m_lineHeight : BLANK_LINE_HEIGHT;
 }
 
-void KompareListViewItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+void KompareListView::layoutBlocks()
 {
-    int column = index.column();
-    QStyleOptionViewItem changedOption = option;
-    if (column == COL_LINE_NO)
-        changedOption.displayAlignment = Qt::AlignRight;
-    KompareListViewItem* item = static_cast<KompareListViewItem*>(static_cast<KompareListView*>(parent())->itemFromIndex(index));
-    item->paintCell(painter, changedOption, column);
-}
+    QVector<qint64> heights;
+    QVector<qint64> shifts;
+    heights.reserve(m_blocks.size());
+    shifts.reserve(m_blocks.size());
+    qint64 scrollId = 0;
 
-QSize KompareListViewItemDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
-{
-    KompareListViewItem* item = static_cast<KompareListViewItem*>(static_cast<KompareListView*>(parent())->itemFromIndex(index));
-    QSize hint = QStyledItemDelegate::sizeHint(option, index);
-    return QSize(hint.width() + ITEM_MARGIN, item->height());
-}
+    for (Block& block : m_blocks) {
+        block.scrollId = scrollId;
+        scrollId += block.maxHeight;
+        heights.append(block.height);
+        shifts.append(lineShift(block));
+    }
 
-KompareListViewItem::KompareListViewItem(KompareListView* parent, int type)
-    : QTreeWidgetItem(parent, type),
-      m_scrollId(0),
-      m_height(0),
-      m_paintHeight(0),
-      m_paintOffset(parent->nextPaintOffset())
-{
-//     qCDebug(KOMPAREPART) << "Created KompareListViewItem with scroll id " << m_scrollId ;
-}
+    m_heightIndex.reset(heights);
+    m_lineShifts.reset(shifts);
+}
+
+void KompareListView::updateColumnWidths()
+{
+    const QFontMetrics fm(font());
+    const int tabstop = m_settings->m_tabToNumberOfSpaces;
+    m_columnTabWidth = tabstop;
+    const bool fixedPitch = QFontInfo(font()).fixedPitch();
+    int maxLineNumber = 0;
+    int maxColumns = 0;
+    // the lines whose width can not be derived from their column count
+    QVector<QString> lines;
+
+    auto addLine = [&](const QString& text) {
+        bool narrow;
+        maxColumns = qMax(maxColumns, displayColumns(text, tabstop, narrow));
+        if (!fixedPitch || !narrow)
+            lines.append(text);
+    };
+
+    for (const Block& block : qAsConst(m_blocks)) {
+        if (block.type != Block::Diff)
+            continue;
+
+        const Difference* diff = block.difference;
+        // the destination pane shows the source lines of applied differences
+        bool source = m_isSource || diff->type() != Difference::Unchanged;
+        bool destination = !m_isSource;
+
+        if (source) {
+            maxLineNumber = qMax(maxLineNumber, diff->sourceLineNumber() + diff->sourceLineCount());
+            for (int i = 0; i < diff->sourceLineCount(); ++i)
+                addLine(diff->sourceLineAt(i)->string());
+        }
+        if (destination) {
+            maxLineNumber = qMax(maxLineNumber, diff->destinationLineNumber() + diff->destinationLineCount());
+            for (int i = 0; i < diff->destinationLineCount(); ++i)
+                addLine(diff->destinationLineAt(i)->string());
+        }
+    }
 
-KompareListViewItem::KompareListViewItem(KompareListView* parent, KompareListViewItem* after, int type)
-    : QTreeWidgetItem(parent, after, type),
-      m_scrollId(after->scrollId() + after->maxHeight()),
-      m_height(0),
-      m_paintHeight(0),
-      m_paintOffset(parent->nextPaintOffset())
-{
-//     qCDebug(KOMPAREPART) << "Created KompareListViewItem with scroll id " << m_scrollId ;
+    m_lineNumberWidth = m_blocks.isEmpty() ? 0 : textWidth(fm, QString::number(maxLineNumber)) + 3 * ITEM_MARGIN;
+
+    // Start with an estimate from the column count, exact for fixed pitch fonts
+    const int charWidth = fixedPitch ? textWidth(fm, QStringLiteral(" ")) : fm.averageCharWidth();
+    m_maxMainWidth = m_blocks.isEmpty() ? 0 : maxColumns * charWidth + 3 * ITEM_MARGIN;
+    m_widthModel = nullptr;
+
+    if (lines.isEmpty())
+        return;
+
+    // and measure the rest on a worker thread
+    m_widthModel = m_selectedModel;
+    m_widthBase = fixedPitch ? m_maxMainWidth : 0;
+    m_widthWatcher.setFuture(QtConcurrent::run(measureWidestLine, lines, font(), tabstop));
 }
 
-KompareListViewItem::KompareListViewItem(KompareListViewItem* parent, int type)
-    : QTreeWidgetItem(parent, type),
-      m_scrollId(0),
-      m_height(0),
-      m_paintHeight(0),
-      m_paintOffset(parent->kompareListView()->nextPaintOffset())
+void KompareListView::slotWidthMeasured()
 {
+    if (!m_widthModel || m_widthModel != m_selectedModel)
+        return;
+
+    m_widthModel = nullptr;
+    m_maxMainWidth = qMax(m_widthBase, m_widthWatcher.result() + 3 * ITEM_MARGIN);
+    qCDebug(KOMPAREPART) << "Measured main column width:" << m_maxMainWidth;
+
+    updateScrollBarRanges();
+    invalidateTiles();
+    viewport()->update();
+    // let the splitter refine its horizontal scroll bar
+    emit resized();
 }
 
-KompareListViewItem::KompareListViewItem(KompareListViewItem* parent, KompareListViewItem* /*after*/, int type)
-    : QTreeWidgetItem(parent, type),
-      m_scrollId(0),
-      m_height(0),
-      m_paintHeight(0),
-      m_paintOffset(parent->kompareListView()->nextPaintOffset())
+void KompareListView::updateScrollBarRanges()
 {
+    // the content may have become shorter than the position shown
+    setContentsY(m_contentsY);
+    horizontalScrollBar()->setRange(0, qMax(0, contentsWidth() - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    publishScrollGeometry();
 }
 
-int KompareListViewItem::height() const
+void KompareListView::setScrollGeometry(KompareScrollGeometry* geometry)
 {
-    return m_height;
+    m_scrollGeometry = geometry;
+    publishScrollGeometry();
 }
 
-void KompareListViewItem::setHeight(int h)
+void KompareListView::setHighlighter(KompareHighlighter* highlighter)
 {
-    m_height = m_paintHeight = h;
-    // QTreeWidget doesn't like zero height, fudge around it.
-    m_height -= m_paintOffset;
-    if (m_height <= 0) {
-        kompareListView()->setNextPaintOffset(1 - m_height);
-        m_height = 1;
-    } else kompareListView()->setNextPaintOffset(0);
+    m_highlighter = highlighter;
+    connect(m_highlighter, &KompareHighlighter::hunkHighlighted, this, &KompareListView::slotHunkHighlighted);
+    connect(m_highlighter, &KompareHighlighter::reset, this, &KompareListView::slotHighlightingReset);
 }
 
-int KompareListViewItem::paintHeight() const
+void KompareListView::slotHunkHighlighted(const DiffHunk* hunk)
 {
-    return m_paintHeight;
+    // the blocks of a hunk follow its header
+    QHash<const DiffHunk*, int>::ConstIterator it = m_hunkDict.constFind(hunk);
+    if (it == m_hunkDict.constEnd())
+        return;
+
+    const int first = *it;
+    int last = first;
+    while (last + 1 < m_blocks.size() && m_blocks[last + 1].type == Block::Diff && m_blocks[last + 1].hunk == hunk)
+        ++last;
+
+    // the layouts of the lines are rebuilt with the colors when they are painted
+    invalidateContents(m_heightIndex.offset(first), m_heightIndex.offset(last) + m_blocks[last].height - 1);
 }
 
-int KompareListViewItem::paintOffset() const
+void KompareListView::slotHighlightingReset()
 {
-    return m_paintOffset;
+    clearLineLayouts();
+    invalidateTiles();
+    viewport()->update();
 }
 
-bool KompareListViewItem::isCurrent() const
+void KompareListView::publishScrollGeometry()
 {
-    return treeWidget()->currentItem() == this;
+    if (!m_scrollGeometry)
+        return;
+
+    KompareScrollGeometry::Pane pane;
+    pane.contentsWidth = contentsWidth();
+    pane.contentsHeight = contentsHeight();
+    pane.visibleWidth = visibleWidth();
+    pane.pageSize = visibleHeight() - style()->pixelMetric(QStyle::PM_ScrollBarExtent);
+    pane.contentsX = contentsX();
+    pane.minScrollId = minScrollId();
+    pane.maxScrollId = maxScrollId();
+    m_scrollGeometry->setPane(this, pane);
 }
 
-KompareListView* KompareListViewItem::kompareListView() const
+const Difference* KompareListView::differenceAt(const QPoint& pos) const
 {
-    return (KompareListView*)treeWidget();
+    const qint64 y = pos.y() + contentsY();
+    int i = blockAt(y);
+    if (i == m_blocks.size())
+        return nullptr;
+
+    // zero height hunks are skipped by blockAt, so a diff item shines through
+    const Block& block = m_blocks[i];
+    return block.type == Block::Diff ? block.difference : nullptr;
 }
 
-void KompareListViewItem::paintCell(QPainter* p, const QStyleOptionViewItem& option, int column)
+void KompareListView::mousePressEvent(QMouseEvent* e)
 {
-    // Default implementation for zero-height items.
-    // We have to paint the item which shines through or we'll end up with glitches.
-    KompareListViewItem* nextItem = (KompareListViewItem*)kompareListView()->itemBelow(this);
-    if (nextItem) {
-        QStyleOptionViewItem changedOption = option;
-        changedOption.rect.translate(0, height());
-        nextItem->paintCell(p, changedOption, column);
+    QPoint vp = e->pos();
+    const Difference* diff = differenceAt(vp);
+    if (diff && diff->type() != Difference::Unchanged) {
+        emit differenceClicked(diff);
     }
 }
 
-KompareListViewDiffItem::KompareListViewDiffItem(KompareListView* parent, Difference* difference)
-    : KompareListViewItem(parent, Diff),
-      m_difference(difference),
-      m_sourceItem(nullptr),
-      m_destItem(nullptr)
+void KompareListView::mouseDoubleClickEvent(QMouseEvent* e)
 {
-    init();
+    QPoint vp = e->pos();
+    const Difference* diff = differenceAt(vp);
+    if (diff && diff->type() != Difference::Unchanged) {
+        // FIXME: make a new signal that does both
+        emit differenceClicked(diff);
+        emit applyDifference(!diff->applied());
+    }
 }
 
-KompareListViewDiffItem::KompareListViewDiffItem(KompareListView* parent, KompareListViewItem* after, Difference* difference)
-    : KompareListViewItem(parent, after, Diff),
-      m_difference(difference),
-      m_sourceItem(nullptr),
-      m_destItem(nullptr)
+int KompareListView::lineShift(const Block& block) const
 {
-    init();
+    // Applied differences in the destination show their source lines,
+    // which moves the numbers of every line below them
+    if (m_isSource || block.type != Block::Diff)
+        return 0;
+    return lineCount(block) - block.difference->destinationLineCount();
 }
 
-KompareListViewDiffItem::~KompareListViewDiffItem()
+void KompareListView::applyDifference(const Difference* diff)
 {
-    m_difference = nullptr;
-}
+    qCDebug(KOMPAREPART) << "KompareListView::applyDifference( " << diff << " )" ;
+    QHash<const Difference*, int>::ConstIterator it = m_itemDict.constFind(diff);
+    if (it == m_itemDict.constEnd())
+        return;
 
-void KompareListViewDiffItem::init()
-{
-    setHeight(0);
-    setExpanded(true);
-    int nextPaintOffset = kompareListView()->nextPaintOffset();
-    m_destItem = new KompareListViewLineContainerItem(this, false);
-    kompareListView()->setNextPaintOffset(nextPaintOffset);
-    m_sourceItem = new KompareListViewLineContainerItem(this, true);
-    setVisibility();
+    Block& block = m_blocks[*it];
+    updateBlockHeight(block);
+    m_heightIndex.setHeight(*it, block.height);
+    m_lineShifts.setHeight(*it, lineShift(block));
 }
 
-void KompareListViewDiffItem::setVisibility()
+void KompareListView::slotApplyDifference(bool /*apply*/)
 {
-    m_sourceItem->setHidden(!(kompareListView()->isSource() || m_difference->applied()));
-    m_destItem->setHidden(!m_sourceItem->isHidden());
+    applyDifference(m_selectedDifference);
+    updateScrollBarRanges();
+    invalidateTiles();
+    viewport()->update();
 }
 
-void KompareListViewDiffItem::applyDifference(bool apply)
+void KompareListView::slotApplyAllDifferences(bool /*apply*/)
 {
-    qCDebug(KOMPAREPART) << "KompareListViewDiffItem::applyDifference( " << apply << " )" ;
-    setVisibility();
+    // Update the blocks in one pass and rebuild the indexes once
+    for (int i : qAsConst(m_items))
+        updateBlockHeight(m_blocks[i]);
+    layoutBlocks();
+
+    updateScrollBarRanges();
+    invalidateTiles();
+    viewport()->update();
 }
 
-int KompareListViewDiffItem::maxHeight()
+void KompareListView::slotApplyDifference(const Difference* diff, bool /*apply*/)
 {
-    int lines = qMax(m_difference->sourceLineCount(), m_difference->destinationLineCount());
-    if (lines == 0)
-        return BLANK_LINE_HEIGHT;
-    else
-        return lines * treeWidget()->fontMetrics().height();
+    applyDifference(diff);
+    updateScrollBarRanges();
+    invalidateTiles();
+    viewport()->update();
 }
 
-KompareListViewLineContainerItem::KompareListViewLineContainerItem(KompareListViewDiffItem* parent, bool isSource)
-    : KompareListViewItem(parent, Container),
-      m_blankLineItem(nullptr),
-      m_isSource(isSource)
+void KompareListView::changeEvent(QEvent* e)
 {
-//     qCDebug(KOMPAREPART) << "isSource ? " << (isSource ? " Yes!" : " No!") ;
-    setHeight(0);
-    setExpanded(true);
-
-    int lines = lineCount();
-    int line = lineNumber();
-//     qCDebug(KOMPAREPART) << "LineNumber : " << lineNumber() ;
-    if (lines == 0) {
-        m_blankLineItem = new KompareListViewBlankLineItem(this);
-        return;
-    }
-
-    for (int i = 0; i < lines; ++i, ++line) {
-        new KompareListViewLineItem(this, line, lineAt(i));
+    if (e->type() == QEvent::FontChange) {
+        m_lineHeight = fontMetrics().height();
+        // all cached heights and widths are off now
+        m_paneStates.clear();
+        if (m_selectedModel) {
+            for (Block& block : m_blocks)
+                updateBlockHeight(block);
+            layoutBlocks();
+            updateColumnWidths();
+            updateScrollBarRanges();
+        }
+        invalidateTiles();
+        viewport()->update();
     }
+    QAbstractScrollArea::changeEvent(e);
 }
 
-KompareListViewLineContainerItem::~KompareListViewLineContainerItem()
+void KompareListView::wheelEvent(QWheelEvent* e)
 {
+    e->ignore(); // we want the parent to catch wheel events
 }
 
-KompareListViewDiffItem* KompareListViewLineContainerItem::diffItemParent() const
+void KompareListView::resizeEvent(QResizeEvent* e)
 {
-    return (KompareListViewDiffItem*)parent();
+    QAbstractScrollArea::resizeEvent(e);
+    updateScrollBarRanges();
+    emit resized();
 }
 
-int KompareListViewLineContainerItem::lineCount() const
+void KompareListView::scrollContentsBy(int dx, int dy)
 {
-    return m_isSource ? diffItemParent()->difference()->sourceLineCount() :
-           diffItemParent()->difference()->destinationLineCount();
+    // the tiles are in contents coordinates, what stays visible is moved
+    // and only the uncovered strip is drawn from them
+    if (dx)
+        publishScrollGeometry();
+    viewport()->scroll(dx, dy);
 }
 
-int KompareListViewLineContainerItem::lineNumber() const
+void KompareListView::paintEvent(QPaintEvent* e)
 {
-    return m_isSource ? diffItemParent()->difference()->sourceLineNumber() :
-           diffItemParent()->difference()->destinationLineNumber();
-}
+    validateLineLayouts();
+    if (viewport()->devicePixelRatioF() != m_tileDevicePixelRatio) {
+        m_tileDevicePixelRatio = viewport()->devicePixelRatioF();
+        invalidateTiles();
+    }
 
-DifferenceString* KompareListViewLineContainerItem::lineAt(int i) const
-{
-    return m_isSource ? diffItemParent()->difference()->sourceLineAt(i) :
-           diffItemParent()->difference()->destinationLineAt(i);
-}
+    QPainter p(viewport());
 
-KompareListViewLineItem::KompareListViewLineItem(KompareListViewLineContainerItem* parent, int line, DifferenceString* text)
-    : KompareListViewItem(parent, Line)
-{
-    init(line, text);
+    const QRect rect = e->rect();
+    const int firstBand = int((rect.top() + contentsY()) / TILE_HEIGHT);
+    const int lastBand = int((rect.bottom() + contentsY()) / TILE_HEIGHT);
+    const int firstColumn = (rect.left() + contentsX()) / TILE_WIDTH;
+    const int lastColumn = (rect.right() + contentsX()) / TILE_WIDTH;
+
+    // the hunk at the top is highlighted first
+    const int top = blockAt(contentsY());
+    if (m_highlighter && top < m_blocks.size())
+        m_highlighter->setVisibleHunk(m_blocks[top].hunk);
+
+    for (int band = firstBand; band <= lastBand; ++band) {
+        for (int column = firstColumn; column <= lastColumn; ++column)
+            p.drawImage(column * TILE_WIDTH - contentsX(), int(qint64(band) * TILE_HEIGHT - contentsY()), tile(band, column));
+    }
+
+    prefetchTiles(firstBand, lastBand, firstColumn, lastColumn);
+
+    if (m_layoutHits + m_layoutMisses >= 10000) {
+        qCDebug(KOMPARERENDER) << "Line layout cache:" << m_layoutHits << "hits," << m_layoutMisses << "misses,"
+                               << m_lineLayouts.count() << "lines cached";
+        m_layoutHits = 0;
+        m_layoutMisses = 0;
+    }
+
+    if (m_tileHits + m_tileMisses >= 500) {
+        qCDebug(KOMPARERENDER) << "Tiles:" << m_tileHits << "hits," << m_tileMisses << "misses,"
+                               << m_tilesPrefetched << "prefetched," << m_tileRenderTime / 1000 << "us rendering";
+        m_tileHits = 0;
+        m_tileMisses = 0;
+        m_tilesPrefetched = 0;
+        m_tileRenderTime = 0;
+    }
 }
 
-KompareListViewLineItem::KompareListViewLineItem(KompareListViewLineContainerItem* parent, int line, DifferenceString* text, int type)
-    : KompareListViewItem(parent, type)
+void KompareListView::invalidateTiles()
 {
-    init(line, text);
+    m_tiles.clear();
+    m_pendingTiles.clear();
 }
 
-KompareListViewLineItem::~KompareListViewLineItem()
+QImage KompareListView::tile(int band, int column)
 {
-    m_text = nullptr;
+    const quint64 key = tileKey(band, column);
+    const QImage* cached = m_tiles.object(key);
+    if (cached) {
+        ++m_tileHits;
+        return *cached;
+    }
+    ++m_tileMisses;
+
+    const KompareRenderedTile rendered = renderTile(snapshotTile(band, column));
+    m_tileRenderTime += rendered.renderTime;
+    insertTile(key, rendered.image);
+    return rendered.image;
 }
 
-void KompareListViewLineItem::init(int line, DifferenceString* text)
+void KompareListView::insertTile(quint64 key, const QImage& image)
 {
-    setHeight(treeWidget()->fontMetrics().height());
-    setText(COL_LINE_NO, QString::number(line));
-    setText(COL_MAIN, text->string());
-    m_text = text;
+    const int cost = image.bytesPerLine() * image.height() / 1024 + 1;
+    if (cost <= m_tiles.maxCost())
+        m_tiles.insert(key, new QImage(image), cost);
 }
 
-void KompareListViewLineItem::paintCell(QPainter* p, const QStyleOptionViewItem& option, int column)
+void KompareListView::prefetchTiles(int firstBand, int lastBand, int firstColumn, int lastColumn)
 {
-    int width = option.rect.width();
-    Qt::Alignment align = option.displayAlignment;
+    const int lastContentsBand = int((m_heightIndex.total() - 1) / TILE_HEIGHT);
 
-    p->setRenderHint(QPainter::Antialiasing);
-    p->translate(option.rect.topLeft());
-    p->translate(0, -paintOffset());
+    // only the bands above and below, in the columns that are shown
+    for (int band = firstBand - PREFETCH_TILES; band <= lastBand + PREFETCH_TILES; ++band) {
+        if (band < 0 || band > lastContentsBand)
+            continue;
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const quint64 key = tileKey(band, column);
+            if (m_tiles.contains(key) || m_pendingTiles.contains(key))
+                continue;
 
-    QColor bg(Qt::white);   // Always make the background white when it is not a real difference
-    if (diffItemParent()->difference()->type() == Difference::Unchanged)
-    {
-        if (column == COL_LINE_NO)
-        {
-            bg = QColor(Qt::lightGray);
+            // The snapshot is taken here, the worker never touches the model
+            QFutureWatcher<KompareRenderedTile>* watcher = new QFutureWatcher<KompareRenderedTile>(this);
+            m_pendingTiles.insert(key, watcher);
+            connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, key]() {
+                // the tile may have been dropped, and maybe requested again, meanwhile
+                if (m_pendingTiles.value(key) == watcher) {
+                    const KompareRenderedTile rendered = watcher->result();
+                    m_pendingTiles.remove(key);
+                    m_tileRenderTime += rendered.renderTime;
+                    ++m_tilesPrefetched;
+                    insertTile(key, rendered.image);
+                }
+                watcher->deleteLater();
+            });
+            watcher->setFuture(QtConcurrent::run(renderTile, snapshotTile(band, column)));
         }
     }
-    else
-    {
-        bg = kompareListView()->settings()->colorForDifferenceType(
-                 diffItemParent()->difference()->type(),
-                 diffItemParent()->isCurrent(),
-                 diffItemParent()->difference()->applied());
+}
+
+KompareTileSnapshot KompareListView::snapshotTile(int band, int column)
+{
+    KompareTileSnapshot tile;
+    tile.size = QSize(TILE_WIDTH, TILE_HEIGHT);
+    tile.devicePixelRatio = m_tileDevicePixelRatio;
+    tile.x = column * TILE_WIDTH;
+    tile.lineNumberWidth = m_lineNumberWidth;
+    tile.font = m_layoutFont;
+    tile.boldFont = m_layoutBoldFont;
+    tile.base = palette().color(QPalette::Base);
+
+    const qint64 top = qint64(band) * TILE_HEIGHT;
+    const qint64 bottom = top + TILE_HEIGHT - 1;
+    const int end = m_blocks.size();
+    int i = blockAt(top);
+    qint64 y = i < end ? m_heightIndex.offset(i) : m_heightIndex.total();
+    for (; i < end && y <= bottom; ++i) {
+        const Block& block = m_blocks[i];
+        if (!block.height)
+            continue;
+        if (block.type == Block::Hunk)
+            appendHunk(tile, block, int(y - top));
+        else
+            appendDifference(tile, block, block.lineNumber + int(m_lineShifts.offset(i)), y - top);
+        y += block.height;
     }
 
-    // Paint background
-    p->fillRect(0, 0, width, paintHeight(), bg);
+    return tile;
+}
 
-    // Paint foreground
-    if (diffItemParent()->difference()->type() == Difference::Unchanged)
-        p->setPen(QColor(Qt::darkGray));     // always make normal text gray
-    else
-        p->setPen(QColor(Qt::black));     // make text with changes black
+void KompareListView::appendHunk(KompareTileSnapshot& tile, const Block& block, int y)
+{
+    KompareTileRow row;
+    row.type = KompareTileRow::Hunk;
+    row.y = y;
+    row.height = int(block.height);
+    row.background = QColor(Qt::lightGray);     // Hunk headers should be lightgray
+    row.foreground = QColor(Qt::black);     // Text color in hunk should be black
+    row.textRect = QRect(m_lineNumberWidth + ITEM_MARGIN, y, m_maxMainWidth - ITEM_MARGIN, row.height);
+    row.text = block.hunk->function();
+    row.topBorder = false;
+    row.bottomBorder = false;
+    tile.rows.append(row);
+}
 
-    paintText(p, bg, column, width, align);
+void KompareListView::appendDifference(KompareTileSnapshot& tile, const Block& block, int lineNumber, qint64 y)
+{
+    const int lines = lineCount(block);
 
-    // Paint darker lines around selected item
-    if (diffItemParent()->isCurrent())
-    {
-        p->translate(0.5, 0.5);
-        p->setPen(bg.darker(135));
-        QTreeWidgetItem* parentItem = parent();
-        if (this == parentItem->child(0))
-            p->drawLine(0, 0, width, 0);
-        if (this == parentItem->child(parentItem->childCount() - 1))
-            p->drawLine(0, paintHeight() - 1, width, paintHeight() - 1);
+    if (lines == 0) {
+        appendLine(tile, block, nullptr, -1, lineNumber, int(y), int(block.height));
+        return;
     }
 
-    p->resetTransform();
+    // only the lines that intersect the tile, y is relative to its top and may be far above it
+    int first = int(qMax<qint64>(0, -y / m_lineHeight));
+    int last = int(qMin<qint64>(lines - 1, (TILE_HEIGHT - 1 - y) / m_lineHeight));
+    for (int i = first; i <= last; ++i)
+        appendLine(tile, block, lineAt(block, i), i, lineNumber + i, int(y + qint64(i) * m_lineHeight), m_lineHeight);
 }
 
-void KompareListViewLineItem::paintText(QPainter* p, const QColor& bg, int column, int width, int align)
+void KompareListView::appendLine(KompareTileSnapshot& tile, const Block& block, DifferenceString* text, int line, int lineNumber, int y, int height)
 {
-    if (column == COL_MAIN)
-    {
-        QString textChunk;
-        int offset = ITEM_MARGIN;
-        int prevValue = 0;
-        int charsDrawn = 0;
-        int chunkWidth;
-        QBrush changeBrush(bg, Qt::Dense3Pattern);
-        QBrush normalBrush(bg, Qt::SolidPattern);
-        QBrush brush;
-
-        if (m_text->string().isEmpty())
-        {
-            p->fillRect(0, 0, width, paintHeight(), normalBrush);
-            return;
-        }
+    const Difference* diff = block.difference;
+    const bool current = (diff == m_selectedDifference);
 
-        p->fillRect(0, 0, offset, paintHeight(), normalBrush);
-
-        if (!m_text->markerList().isEmpty())
-        {
-            MarkerListConstIterator markerIt = m_text->markerList().begin();
-            MarkerListConstIterator mEnd     = m_text->markerList().end();
-            Marker* m = *markerIt;
-
-            for (; markerIt != mEnd; ++markerIt)
-            {
-                m  = *markerIt;
-                textChunk = m_text->string().mid(prevValue, m->offset() - prevValue);
-//                 qCDebug(KOMPAREPART) << "TextChunk   = \"" << textChunk << "\"" ;
-//                 qCDebug(KOMPAREPART) << "c->offset() = " << c->offset() ;
-//                 qCDebug(KOMPAREPART) << "prevValue   = " << prevValue ;
-                expandTabs(textChunk, kompareListView()->settings()->m_tabToNumberOfSpaces, charsDrawn);
-                charsDrawn += textChunk.length();
-                prevValue = m->offset();
-                if (m->type() == Marker::End)
-                {
-                    QFont font(p->font());
-                    font.setBold(true);
-                    p->setFont(font);
-//                     p->setPen( Qt::blue );
-                    brush = changeBrush;
-                }
-                else
-                {
-                    QFont font(p->font());
-                    font.setBold(false);
-                    p->setFont(font);
-//                     p->setPen( Qt::black );
-                    brush = normalBrush;
-                }
-#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
-                chunkWidth = p->fontMetrics().horizontalAdvance(textChunk);
-#else
-                chunkWidth = p->fontMetrics().width(textChunk);
-#endif
-                p->fillRect(offset, 0, chunkWidth, paintHeight(), brush);
-                p->drawText(offset, 0,
-                            chunkWidth, paintHeight(),
-                            align, textChunk);
-                offset += chunkWidth;
-            }
-        }
-        if (prevValue < m_text->string().length())
-        {
-            // Still have to draw some string without changes
-            textChunk = m_text->string().mid(prevValue, qMax(1, m_text->string().length() - prevValue));
-            expandTabs(textChunk, kompareListView()->settings()->m_tabToNumberOfSpaces, charsDrawn);
-//             qCDebug(KOMPAREPART) << "TextChunk   = \"" << textChunk << "\"" ;
-            QFont font(p->font());
-            font.setBold(false);
-            p->setFont(font);
-#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
-            chunkWidth = p->fontMetrics().horizontalAdvance(textChunk);
-#else
-            chunkWidth = p->fontMetrics().width(textChunk);
-#endif
-            p->fillRect(offset, 0, chunkWidth, paintHeight(), normalBrush);
-            p->drawText(offset, 0,
-                        chunkWidth, paintHeight(),
-                        align, textChunk);
-            offset += chunkWidth;
-        }
-        p->fillRect(offset, 0, width - offset, paintHeight(), normalBrush);
+    KompareTileRow row;
+    row.type = text ? KompareTileRow::Line : KompareTileRow::Blank;
+    row.y = y;
+    row.height = height;
+    row.background = QColor(Qt::white);   // Always make the background white when it is not a real difference
+    row.lineNumberBackground = QColor(Qt::lightGray);
+    if (diff->type() != Difference::Unchanged)
+    {
+        row.background = m_settings->colorForDifferenceType(diff->type(), current, diff->applied());
+        row.lineNumberBackground = row.background;
     }
+
+    if (diff->type() == Difference::Unchanged)
+        row.foreground = QColor(Qt::darkGray);     // always make normal text gray
     else
+        row.foreground = QColor(Qt::black);     // make text with changes black
+
+    if (text)
     {
-        p->fillRect(0, 0, width, paintHeight(), bg);
-        p->drawText(ITEM_MARGIN, 0,
-                    width - ITEM_MARGIN, paintHeight(),
-                    align, text(column));
+        row.textRect = QRect(ITEM_MARGIN, y, m_lineNumberWidth - 2 * ITEM_MARGIN, height);
+        row.text = QString::number(lineNumber);
+        // only the part of the line in the tile
+        const int left = tile.x - m_lineNumberWidth;
+        appendText(row, text, left, left + tile.size.width());
     }
-}
 
-void KompareListViewLineItem::expandTabs(QString& text, int tabstop, int startPos) const
-{
-    int index;
-    while ((index = text.indexOf(QChar(9))) != -1)
-        text.replace(index, 1, QString(tabstop - ((startPos + index) % tabstop), QLatin1Char(' ')));
+    // darker lines around selected item
+    row.topBorder = current && line <= 0;
+    row.bottomBorder = current && (line < 0 || line == lineCount(block) - 1);
+    tile.rows.append(row);
 }
 
-KompareListViewDiffItem* KompareListViewLineItem::diffItemParent() const
+void KompareListView::appendText(KompareTileRow& row, DifferenceString* text, int left, int right)
 {
-    KompareListViewLineContainerItem* p = (KompareListViewLineContainerItem*)parent();
-    return p->diffItemParent();
-}
+    const LineLayout* layout = lineLayout(text);
 
-KompareListViewBlankLineItem::KompareListViewBlankLineItem(KompareListViewLineContainerItem* parent)
-    : KompareListViewLineItem(parent, 0, new DifferenceString(), Blank)
-{
-    setHeight(BLANK_LINE_HEIGHT);
-}
+    // Segments are ordered by x, start at the first one reaching into [left, right]
+    QVector<LineLayout::Segment>::const_iterator it = std::lower_bound(layout->segments.constBegin(), layout->segments.constEnd(), left,
+                                                                       [](const LineLayout::Segment& segment, int x) { return segment.x + segment.width <= x; });
+    QVector<LineLayout::Segment>::const_iterator end = layout->segments.constEnd();
 
-void KompareListViewBlankLineItem::paintText(QPainter* p, const QColor& bg, int column, int width, int /* align */)
-{
-    if (column == COL_MAIN)
+    for (; it != end && it->x <= right; ++it)
     {
-        QBrush normalBrush(bg, Qt::SolidPattern);
-        p->fillRect(0, 0, width, paintHeight(), normalBrush);
+        KompareTileRun run;
+        run.text = it->text;
+        run.x = m_lineNumberWidth + it->x;
+        run.width = it->width;
+        run.changed = it->changed;
+        run.color = it->color;
+        row.runs.append(run);
     }
 }
 
-KompareListViewHunkItem::KompareListViewHunkItem(KompareListView* parent, DiffHunk* hunk, bool zeroHeight)
-    : KompareListViewItem(parent, Hunk),
-      m_zeroHeight(zeroHeight),
-      m_hunk(hunk)
+void KompareListView::validateLineLayouts()
 {
-    setHeight(maxHeight());
-    setFlags(flags() & ~Qt::ItemIsSelectable);
-}
+    if (font() == m_layoutFont && m_settings->m_tabToNumberOfSpaces == m_layoutTabWidth)
+        return;
 
-KompareListViewHunkItem::KompareListViewHunkItem(KompareListView* parent, KompareListViewItem* after, DiffHunk* hunk,  bool zeroHeight)
-    : KompareListViewItem(parent, after, Hunk),
-      m_zeroHeight(zeroHeight),
-      m_hunk(hunk)
-{
-    setHeight(maxHeight());
-    setFlags(flags() & ~Qt::ItemIsSelectable);
+    clearLineLayouts();
+    invalidateTiles();
+    m_layoutFont = font();
+    m_layoutBoldFont = m_layoutFont;
+    m_layoutBoldFont.setBold(true);
+    m_layoutTabWidth = m_settings->m_tabToNumberOfSpaces;
+    m_layoutFixedPitch = QFontInfo(m_layoutFont).fixedPitch();
+    m_layoutCharWidth = textWidth(QFontMetrics(m_layoutFont), QStringLiteral(" "));
+    m_layoutBoldCharWidth = textWidth(QFontMetrics(m_layoutBoldFont), QStringLiteral(" "));
 }
 
-KompareListViewHunkItem::~KompareListViewHunkItem()
+void KompareListView::clearLineLayouts()
 {
-    m_hunk = nullptr;
+    if (m_layoutHits || m_layoutMisses)
+        qCDebug(KOMPARERENDER) << "Line layout cache cleared after" << m_layoutHits << "hits and" << m_layoutMisses << "misses";
+    m_lineLayouts.clear();
+    m_layoutHits = 0;
+    m_layoutMisses = 0;
 }
 
-int KompareListViewHunkItem::maxHeight()
+const KompareListView::LineLayout* KompareListView::lineLayout(DifferenceString* text)
 {
-    if (m_zeroHeight) {
-        return 0;
-    } else if (m_hunk->function().isEmpty()) {
-        return HUNK_LINE_HEIGHT;
-    } else {
-        return treeWidget()->fontMetrics().height();
+    // a layout made before the line was highlighted is made again
+    const LineLayout* cached = m_lineLayouts.object(text);
+    KompareHighlightSpans spans;
+    const bool highlighted = (cached && cached->highlighted) || (m_highlighter && m_highlighter->spans(text, spans));
+    if (cached && cached->highlighted == highlighted) {
+        ++m_layoutHits;
+        return cached;
     }
-}
+    ++m_layoutMisses;
+
+    LineLayout* layout = new LineLayout;
+    layout->highlighted = highlighted;
+    const QString string = text->string();
+    const QFontMetrics normalMetrics(m_layoutFont);
+    const QFontMetrics boldMetrics(m_layoutBoldFont);
+    int offset = ITEM_MARGIN;
+    int prevValue = 0;
+    int column = 0;
+    int span = 0;
+
+    // Split the line at its markers, the text between a start and an end marker is drawn bold
+    auto addSegment = [&](const QString& text, bool changed, const QColor& color) {
+        const int startColumn = column;
+        bool narrow;
+        const QString expanded = expandTabs(text, m_layoutTabWidth, column, narrow);
+        const int length = expanded.length();
+
+        // Long runs are cut into pieces so painting can skip the ones scrolled out of view
+        for (int start = 0; start < length;)
+        {
+            int end = qMin(start + SEGMENT_LENGTH, length);
+            if (end < length && expanded.at(end).isLowSurrogate())
+                ++end;
+            const QString chunk = (length <= SEGMENT_LENGTH) ? expanded : expanded.mid(start, end - start);
+
+            LineLayout::Segment segment;
+            segment.text = chunk;
+            segment.x = offset;
+            segment.column = startColumn + start;
+            // A fixed pitch font needs no metrics for text that is one column per character
+            if (m_layoutFixedPitch && narrow)
+                segment.width = chunk.length() * (changed ? m_layoutBoldCharWidth : m_layoutCharWidth);
+            else
+                segment.width = textWidth(changed ? boldMetrics : normalMetrics, chunk);
+            segment.changed = changed;
+            segment.color = color;
+            layout->segments.append(segment);
+            offset += segment.width;
+            start = end;
+        }
+    };
+
+    // and again where the syntax color changes, the spans are ordered and do not overlap
+    auto addRange = [&](int from, int to, bool changed) {
+        while (from < to) {
+            while (span < spans.size() && spans[span].offset + spans[span].length <= from)
+                ++span;
+            QColor color;
+            int end = to;
+            if (span < spans.size()) {
+                if (spans[span].offset <= from) {
+                    color = spans[span].color;
+                    end = qMin(to, spans[span].offset + spans[span].length);
+                } else {
+                    end = qMin(to, spans[span].offset);
+                }
+            }
+            addSegment(string.mid(from, end - from), changed, color);
+            from = end;
+        }
+    };
 
-void KompareListViewHunkItem::paintCell(QPainter* p, const QStyleOptionViewItem& option, int column)
-{
-    if (m_zeroHeight) {
-        KompareListViewItem::paintCell(p, option, column);
-    } else {
-        int x = option.rect.left();
-        int y = option.rect.top() - paintOffset();
-        int width = option.rect.width();
-        Qt::Alignment align = option.displayAlignment;
-
-        p->fillRect(x, y, width, paintHeight(), QColor(Qt::lightGray));     // Hunk headers should be lightgray
-        p->setPen(QColor(Qt::black));     // Text color in hunk should be black
-        if (column == COL_MAIN) {
-            p->drawText(x + ITEM_MARGIN, y, width - ITEM_MARGIN, paintHeight(),
-                        align, m_hunk->function());
+    if (!string.isEmpty())
+    {
+        MarkerListConstIterator markerIt = text->markerList().begin();
+        MarkerListConstIterator mEnd     = text->markerList().end();
+
+        for (; markerIt != mEnd; ++markerIt)
+        {
+            Marker* m = *markerIt;
+            addRange(prevValue, m->offset(), m->type() == Marker::End);
+            prevValue = m->offset();
+        }
+        if (prevValue < string.length())
+        {
+            // Still have to draw some string without changes
+            addRange(prevValue, string.length(), false);
         }
     }
+
+    m_lineLayouts.insert(text, layout, qMin(string.length() + 1, m_lineLayouts.maxCost()));
+    return layout;
 }
@@ -20,15 +20,23 @@
 #ifndef KOMPARELISTVIEW_H
 #define KOMPARELISTVIEW_H
 
+#include <QAbstractScrollArea>
+#include <QCache>
+#include <QFont>
+#include <QFutureWatcher>
 #include <QHash>
+#include <QImage>
 #include <QLabel>
 #include <QResizeEvent>
 #include <QWheelEvent>
 #include <QVBoxLayout>
+#include <QVector>
 #include <QMouseEvent>
+#include <QPaintEvent>
 #include <QFrame>
-#include <QTreeWidget>
-#include <QStyledItemDelegate>
+
+#include "kompareheightindex.h"
+#include "komparescrollgeometry.h"
 
 namespace Diff2 {
 class DiffModel;
@@ -37,40 +45,57 @@ class Difference;
 class DifferenceString;
 }
 class ViewSettings;
+class KompareHighlighter;
+struct KompareOverviewEntry;
+struct KompareTileRow;
+struct KompareTileSnapshot;
 class KompareSplitter;
-class KompareListView;
-class KompareListViewItem;
-class KompareListViewItemDelegate;
-class KompareListViewDiffItem;
-class KompareListViewLineContainerItem;
 
-class KompareListView : public QTreeWidget
+/**
+ * One of the two diff panes.
+ *
+ * The pane does not create an item per line. When a model is selected it
+ * builds a flat list of blocks, one per hunk header and one per difference,
+ * and paints only the lines that intersect the viewport, reading their text
+ * straight from the Diff2::Difference.
+ */
+class KompareListView : public QAbstractScrollArea
 {
     Q_OBJECT
 
-    friend class KompareListViewItemDelegate;
-
 public:
     KompareListView(bool isSource, ViewSettings* settings, QWidget* parent, const char* name = nullptr);
     ~KompareListView() override;
 
-    KompareListViewItem* itemAtIndex(int i);
     int                  firstVisibleDifference();
     int                  lastVisibleDifference();
     QRect                itemRect(int i);
+    /** The rectangle of diff in viewport coordinates, empty when it is not shown */
+    QRect                differenceRect(const Diff2::Difference* diff);
     int                  minScrollId();
-    int                  maxScrollId();
-    int                  contentsHeight();
+    qint64               maxScrollId();
+    qint64               contentsHeight();
     int                  contentsWidth();
     int                  visibleHeight();
     int                  visibleWidth();
     int                  contentsX();
-    int                  contentsY();
-    int                  nextPaintOffset() const;
-    void                 setNextPaintOffset(int offset);
+    qint64               contentsY();
 
     bool                 isSource() const { return m_isSource; };
+
+    /** Extents are published to geometry whenever the content or viewport changes */
+    void                 setScrollGeometry(KompareScrollGeometry* geometry);
+    /** Colors the text once the lines are highlighted */
+    void                 setHighlighter(KompareHighlighter* highlighter);
     ViewSettings*        settings() const { return m_settings; };
+    const Diff2::Difference* selectedDifference() const { return m_selectedDifference; };
+
+    /** The changed differences in scroll id space, for the overview ruler */
+    QVector<KompareOverviewEntry> overviewEntries() const;
+    /** Height of the shown model in scroll ids */
+    qint64               scrollHeight() const;
+    /** The scroll id of line of diff as this pane shows it, -1 when diff is not shown */
+    qint64               lineScrollId(const Diff2::Difference* diff, int line) const;
 
     void setSelectedDifference(const Diff2::Difference* diff, bool scroll);
 
@@ -78,11 +103,18 @@ public Q_SLOTS:
     void slotSetSelection(const Diff2::DiffModel* model, const Diff2::Difference* diff);
     void slotSetSelection(const Diff2::Difference* diff);
     void setXOffset(int x);
-    void scrollToId(int id);
-    int  scrollId();
+    void   scrollToId(qint64 id);
+    qint64 scrollId();
     void slotApplyDifference(bool apply);
     void slotApplyAllDifferences(bool apply);
     void slotApplyDifference(const Diff2::Difference* diff, bool apply);
+    void slotModelsChanged();
+    void slotConfigChanged();
+
+private Q_SLOTS:
+    void slotWidthMeasured();
+    void slotHunkHighlighted(const Diff2::DiffHunk* hunk);
+    void slotHighlightingReset();
 
 Q_SIGNALS:
     void differenceClicked(const Diff2::Difference* diff);
@@ -90,6 +122,9 @@ Q_SIGNALS:
     void resized();
 
 protected:
+    void paintEvent(QPaintEvent* e) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void changeEvent(QEvent* e) override;
     void wheelEvent(QWheelEvent* e) override;
     void resizeEvent(QResizeEvent* e) override;
     void mousePressEvent(QMouseEvent* e) override;
@@ -98,19 +133,138 @@ protected:
     void mouseMoveEvent(QMouseEvent*) override {};
 
 private:
-    QRect totalVisualItemRect(QTreeWidgetItem* item);
-    KompareListViewDiffItem* diffItemAt(const QPoint& pos);
-    void renumberLines();
-
-    QList<KompareListViewDiffItem*> m_items;
-    QHash<const Diff2::Difference*, KompareListViewDiffItem*> m_itemDict;
+    // A hunk header or a difference, the lines of a difference are not stored
+    struct Block
+    {
+        enum Type { Hunk, Diff };
+
+        Type               type;
+        Diff2::DiffHunk*   hunk;
+        Diff2::Difference* difference;
+        int                change;     // number of changed differences before this block
+        qint64             scrollId;   // shared by both panes
+        qint64             maxHeight;  // height in scroll id space, the same in both panes
+        qint64             height;     // height of the block in this pane, its top comes from m_heightIndex
+        int                lineNumber; // number of the first line before any difference above is applied
+    };
+
+    // The text of a line split at its markers, measured once and kept in a cache
+    struct LineLayout
+    {
+        struct Segment
+        {
+            QString     text;
+            int         x;
+            int         column;     // display column of the first character, tabs expanded
+            int         width;
+            bool        changed;
+            QColor      color;      // syntax highlighting, invalid when there is none
+        };
+
+        QVector<Segment> segments;
+        bool             highlighted;
+    };
+
+    // The layout of a model that is not shown, kept so selecting it again does not rebuild it
+    struct PaneState
+    {
+        QVector<Block>                          blocks;
+        QVector<int>                            items;
+        QHash<const Diff2::Difference*, int>    itemDict;
+        QHash<const Diff2::DiffHunk*, int>      hunkDict;
+        KompareHeightIndex                      heightIndex;
+        KompareHeightIndex                      lineShifts;
+        int                                     lineNumberWidth;
+        int                                     maxMainWidth;
+        int                                     tabWidth;
+        qint64                                  scrollId;
+        qint64                                  y;
+        bool                                    widthPending;
+    };
+
+    void saveState();
+    bool restoreState(const Diff2::DiffModel* model);
+    void buildBlocks(const Diff2::DiffModel* model);
+    void layoutBlocks();
+    void updateColumnWidths();
+    void updateScrollBarRanges();
+    void setContentsY(qint64 y);
+    void publishScrollGeometry();
+    void updateBlockHeight(Block& block) const;
+    int  layoutFootprint() const;
+    bool showsSourceLines(const Block& block) const;
+    int  lineCount(const Block& block) const;
+    Diff2::DifferenceString* lineAt(const Block& block, int i) const;
+    int  blockAt(qint64 y) const;
+    int  lineShift(const Block& block) const;
+    void applyDifference(const Diff2::Difference* diff);
+
+    const Diff2::Difference* differenceAt(const QPoint& pos) const;
+
+    QRect blockRect(int i);
+    void invalidateTiles();
+    void invalidateBlock(int i);
+    void invalidateContents(qint64 top, qint64 bottom);
+    QImage tile(int band, int column);
+    void insertTile(quint64 key, const QImage& image);
+    void prefetchTiles(int firstBand, int lastBand, int firstColumn, int lastColumn);
+    KompareTileSnapshot snapshotTile(int band, int column);
+    void appendHunk(KompareTileSnapshot& tile, const Block& block, int y);
+    void appendDifference(KompareTileSnapshot& tile, const Block& block, int lineNumber, qint64 y);
+    void appendLine(KompareTileSnapshot& tile, const Block& block, Diff2::DifferenceString* text, int line, int lineNumber, int y, int height);
+    void appendText(KompareTileRow& row, Diff2::DifferenceString* text, int left, int right);
+    void validateLineLayouts();
+    void clearLineLayouts();
+    const LineLayout* lineLayout(Diff2::DifferenceString* text);
+
+    QVector<Block>                          m_blocks;
+    QVector<int>                            m_items;    // blocks of the non-unchanged differences
+    QHash<const Diff2::Difference*, int>    m_itemDict; // difference -> block, unchanged ones too
+    QHash<const Diff2::DiffHunk*, int>      m_hunkDict; // hunk -> header block
+    KompareHeightIndex                      m_heightIndex;
+    KompareHeightIndex                      m_lineShifts; // lines added by applied differences, per block
     bool                              m_isSource;
+    KompareScrollGeometry*            m_scrollGeometry;
+    KompareHighlighter*               m_highlighter;
     ViewSettings*                     m_settings;
-    int                               m_scrollId;
+    qint64                            m_scrollId;
+    qint64                            m_contentsY; // 64-bit, so the internal vertical scroll bar is not used
+    int                               m_lineHeight;
+    int                               m_lineNumberWidth;
     int                               m_maxMainWidth;
+    int                               m_columnTabWidth; // the tab width the columns were measured with
     const Diff2::DiffModel*           m_selectedModel;
     const Diff2::Difference*          m_selectedDifference;
-    int                               m_nextPaintOffset;
+
+    // Keyed on the line, the layouts are dropped when the font or tab width changes
+    QCache<const Diff2::DifferenceString*, LineLayout> m_lineLayouts;
+    QFont                             m_layoutFont;
+    QFont                             m_layoutBoldFont;
+    int                               m_layoutTabWidth;
+    bool                              m_layoutFixedPitch;
+    int                               m_layoutCharWidth;
+    int                               m_layoutBoldCharWidth;
+    int                               m_layoutHits;
+    int                               m_layoutMisses;
+
+    // Cost in KiB of layout data
+    QCache<const Diff2::DiffModel*, PaneState> m_paneStates;
+
+    // Main column width measured off the GUI thread for the model it was started for
+    QFutureWatcher<int>               m_widthWatcher;
+    const Diff2::DiffModel*           m_widthModel;
+    int                               m_widthBase;
+
+    // Rendered tiles of TILE_WIDTH x TILE_HEIGHT pixels by band and column, cost
+    // in KiB. Tiles are dropped when anything they show changes, together with
+    // the prefetches of their band, scrolling only moves them.
+    QCache<quint64, QImage>           m_tiles;
+    QHash<quint64, QObject*>          m_pendingTiles; // tile -> watcher of its prefetch
+    qreal                             m_tileDevicePixelRatio;
+    int                               m_tileHits;
+    int                               m_tileMisses;
+    int                               m_tilesPrefetched;
+    qint64                            m_tileRenderTime;
 };
 
 class KompareListViewFrame : public QFrame
@@ -131,141 +285,4 @@ private:
     QVBoxLayout          m_layout;
 };
 
-class KompareListViewItemDelegate : public QStyledItemDelegate
-{
-    Q_OBJECT
-
-public:
-    explicit KompareListViewItemDelegate(QObject* parent);
-    ~KompareListViewItemDelegate() override;
-    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
-    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
-};
-
-class KompareListViewItem : public QTreeWidgetItem
-{
-public:
-    KompareListViewItem(KompareListView* parent, int type);
-    KompareListViewItem(KompareListView* parent, KompareListViewItem* after, int type);
-    KompareListViewItem(KompareListViewItem* parent, int type);
-    KompareListViewItem(KompareListViewItem* parent, KompareListViewItem* after, int type);
-
-    virtual void paintCell(QPainter* p, const QStyleOptionViewItem& option, int column);
-
-    void repaint();
-    int height() const;
-    void setHeight(int h);
-    int paintHeight() const;
-    int paintOffset() const;
-    bool isCurrent() const;
-    int scrollId() const { return m_scrollId; };
-
-    virtual int maxHeight() = 0;
-
-    KompareListView* kompareListView() const;
-
-    enum ListViewItemType { Diff = QTreeWidgetItem::UserType + 1, Container = QTreeWidgetItem::UserType + 2, Line = QTreeWidgetItem::UserType + 3, Blank = QTreeWidgetItem::UserType + 4, Hunk = QTreeWidgetItem::UserType + 5 };
-
-private:
-    int     m_scrollId;
-    int     m_height;
-    int     m_paintHeight;
-    int     m_paintOffset;
-};
-
-class KompareListViewDiffItem : public KompareListViewItem
-{
-public:
-    KompareListViewDiffItem(KompareListView* parent, Diff2::Difference* difference);
-    KompareListViewDiffItem(KompareListView* parent, KompareListViewItem* after, Diff2::Difference* difference);
-    ~KompareListViewDiffItem() override;
-
-    void applyDifference(bool apply);
-
-    Diff2::Difference* difference() { return m_difference; };
-
-    int maxHeight() override;
-
-private:
-    void init();
-    void setVisibility();
-
-private:
-    Diff2::Difference* m_difference;
-    KompareListViewLineContainerItem* m_sourceItem;
-    KompareListViewLineContainerItem* m_destItem;
-};
-
-class KompareListViewLineItem;
-class KompareListViewBlankLineItem;
-
-class KompareListViewLineContainerItem : public KompareListViewItem
-{
-public:
-    KompareListViewLineContainerItem(KompareListViewDiffItem* parent, bool isSource);
-    ~KompareListViewLineContainerItem() override;
-
-    int maxHeight() override { return 0; }
-
-    KompareListViewDiffItem* diffItemParent() const;
-
-private:
-    int lineCount() const;
-    int lineNumber() const;
-    Diff2::DifferenceString* lineAt(int i) const;
-
-private:
-    KompareListViewBlankLineItem* m_blankLineItem;
-    bool m_isSource;
-};
-
-class KompareListViewLineItem : public KompareListViewItem
-{
-public:
-    KompareListViewLineItem(KompareListViewLineContainerItem* parent, int line, Diff2::DifferenceString* text);
-    KompareListViewLineItem(KompareListViewLineContainerItem* parent, int line, Diff2::DifferenceString* text, int type);
-    ~KompareListViewLineItem() override;
-
-    int maxHeight() override { return 0; }
-
-    void paintCell(QPainter* p, const QStyleOptionViewItem& option, int column) override;
-
-    KompareListViewDiffItem* diffItemParent() const;
-
-protected:
-    virtual void paintText(QPainter* p, const QColor& bg, int column, int width, int align);
-
-private:
-    void init(int line, Diff2::DifferenceString* text);
-    void expandTabs(QString& text, int tabstop, int startPos = 0) const;
-
-private:
-    Diff2::DifferenceString* m_text;
-};
-
-class KompareListViewBlankLineItem : public KompareListViewLineItem
-{
-public:
-    explicit KompareListViewBlankLineItem(KompareListViewLineContainerItem* parent);
-
-protected:
-    void paintText(QPainter* p, const QColor& bg, int column, int width, int align) override;
-};
-
-class KompareListViewHunkItem : public KompareListViewItem
-{
-public:
-    KompareListViewHunkItem(KompareListView* parent, Diff2::DiffHunk* hunk, bool zeroHeight = false);
-    KompareListViewHunkItem(KompareListView* parent, KompareListViewItem* after, Diff2::DiffHunk* hunk, bool zeroHeight = false);
-    ~KompareListViewHunkItem() override;
-
-    void paintCell(QPainter* p, const QStyleOptionViewItem& option, int column) override;
-
-    int maxHeight() override;
-
-private:
-    bool             m_zeroHeight;
-    Diff2::DiffHunk* m_hunk;
-};
-
 #endif
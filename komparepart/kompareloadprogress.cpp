@@ -0,0 +1,99 @@
+/***************************************************************************
+                                kompareloadprogress.cpp
+                                -----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "kompareloadprogress.h"
+
+#include <QHBoxLayout>
+#include <QIcon>
+#include <QLabel>
+#include <QProgressBar>
+#include <QToolButton>
+
+#include <KLocalizedString>
+
+#include <komparepartdebug.h>
+
+static const char* const stageNames[KompareLoadProgress::Stages] = { "fetch", "read", "diff", "parse", "present" };
+
+KompareLoadProgress::KompareLoadProgress(QWidget* parent) :
+    QWidget(parent),
+    m_stage(Stages)
+{
+    m_label = new QLabel(this);
+
+    m_bar = new QProgressBar(this);
+    m_bar->setRange(0, Stages);
+    m_bar->setTextVisible(false);
+    m_bar->setMaximumWidth(100);
+
+    m_cancel = new QToolButton(this);
+    m_cancel->setIcon(QIcon::fromTheme(QStringLiteral("process-stop")));
+    m_cancel->setToolTip(i18n("Stop Loading"));
+    m_cancel->setAutoRaise(true);
+
+    QHBoxLayout* layout = new QHBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_label);
+    layout->addWidget(m_bar);
+    layout->addWidget(m_cancel);
+
+    connect(m_cancel, &QToolButton::clicked, this, &KompareLoadProgress::cancelRequested);
+
+    hide();
+}
+
+KompareLoadProgress::~KompareLoadProgress()
+{
+}
+
+void KompareLoadProgress::begin(Stage stage, bool cancellable)
+{
+    if (isRunning())
+        endStage();
+    else
+        m_totalTimer.start();
+
+    m_stage = stage;
+    m_stageTimer.start();
+
+    switch (stage) {
+    case Fetch:   m_label->setText(i18n("Downloading")); break;
+    case Read:    m_label->setText(i18n("Reading")); break;
+    case Diff:    m_label->setText(i18n("Comparing")); break;
+    case Parse:   m_label->setText(i18n("Parsing")); break;
+    case Present: m_label->setText(i18n("Showing")); break;
+    default:      break;
+    }
+    m_bar->setValue(stage);
+    m_cancel->setEnabled(cancellable);
+    show();
+}
+
+void KompareLoadProgress::finish()
+{
+    if (!isRunning())
+        return;
+
+    endStage();
+    qCDebug(KOMPAREPART) << "Loading took" << m_totalTimer.elapsed() << "ms";
+    m_stage = Stages;
+    hide();
+}
+
+void KompareLoadProgress::endStage()
+{
+    qCDebug(KOMPAREPART) << "Stage" << stageNames[m_stage] << "took" << m_stageTimer.elapsed() << "ms";
+}
@@ -0,0 +1,65 @@
+/***************************************************************************
+                                kompareloadprogress.h
+                                ---------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPARELOADPROGRESS_H
+#define KOMPARELOADPROGRESS_H
+
+#include <QElapsedTimer>
+#include <QWidget>
+
+class QLabel;
+class QProgressBar;
+class QToolButton;
+
+/**
+ * The stages of loading a comparison or a diff, shown in the status bar.
+ *
+ * Every stage is timed, the times are logged when the next one begins.
+ * The stop button is only enabled while the current stage can be stopped.
+ */
+class KompareLoadProgress : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Stage { Fetch, Read, Diff, Parse, Present, Stages };
+
+    explicit KompareLoadProgress(QWidget* parent = nullptr);
+    ~KompareLoadProgress() override;
+
+    /** Ends the running stage, if any, and begins stage */
+    void begin(Stage stage, bool cancellable);
+    /** Ends the running stage and hides the progress */
+    void finish();
+    bool isRunning() const { return m_stage != Stages; }
+    Stage stage() const { return m_stage; }
+
+Q_SIGNALS:
+    void cancelRequested();
+
+private:
+    void endStage();
+
+    QLabel*        m_label;
+    QProgressBar*  m_bar;
+    QToolButton*   m_cancel;
+
+    Stage          m_stage;
+    QElapsedTimer  m_stageTimer;
+    QElapsedTimer  m_totalTimer;
+};
+
+#endif
@@ -0,0 +1,283 @@
+/***************************************************************************
+                                kompareoverviewruler.cpp
+                                ------------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "kompareoverviewruler.h"
+
+#include <algorithm>
+
+#include <QElapsedTimer>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QtConcurrent>
+
+#include <libkomparediff2/difference.h>
+
+#include <komparerenderdebug.h>
+#include "viewsettings.h"
+
+#define OVERVIEW_WIDTH 12
+// the weakest color of a row any change reaches into, out of 1
+#define MIN_STRENGTH   0.4
+
+using namespace Diff2;
+
+// Everything a build needs, the worker does not touch the model or the settings
+struct KompareOverviewJob
+{
+    QVector<KompareOverviewEntry> entries;
+    qint64                        total;
+    QSize                         size;
+    QColor                        colors[KompareOverviewRuler::Categories];
+    QColor                        base;
+    int                           serial;
+};
+
+// Adds sign times the part of every row entry covers, returns the rows touched
+static void addEntry(QVector<float>& weights, int rows, qint64 total, const KompareOverviewEntry& entry, float sign, int& first, int& last)
+{
+    const double span = double(total) / rows;
+    const double top = entry.top;
+    const double bottom = entry.top + entry.height;
+    first = qBound(0, int(top / span), rows - 1);
+    last = qBound(first, int(bottom / span), rows - 1);
+
+    for (int row = first; row <= last; ++row) {
+        const double covered = qMin(bottom, (row + 1) * span) - qMax(top, row * span);
+        if (covered > 0)
+            weights[row * KompareOverviewRuler::Categories + entry.category] += sign * float(covered);
+    }
+}
+
+// The category covering most of the row wins, more coverage gives a stronger color
+static QRgb rowColor(const float* weights, double span, const QColor* colors, const QColor& base)
+{
+    int best = 0;
+    float sum = 0;
+    for (int category = 0; category < KompareOverviewRuler::Categories; ++category) {
+        sum += weights[category];
+        if (weights[category] > weights[best])
+            best = category;
+    }
+    // applying and unapplying leaves rounding noise behind
+    if (sum < 0.5f)
+        return base.rgb();
+
+    const double strength = MIN_STRENGTH + (1.0 - MIN_STRENGTH) * qMin(1.0, sum / span);
+    const QColor& color = colors[best];
+    return qRgb(int(base.red() + (color.red() - base.red()) * strength),
+                int(base.green() + (color.green() - base.green()) * strength),
+                int(base.blue() + (color.blue() - base.blue()) * strength));
+}
+
+static void paintRows(QImage& image, const QVector<float>& weights, double span, const QColor* colors, const QColor& base, int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        const QRgb color = rowColor(weights.constData() + row * KompareOverviewRuler::Categories, span, colors, base);
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(row));
+        std::fill(line, line + image.width(), color);
+    }
+}
+
+static KompareOverviewDensity buildDensity(const KompareOverviewJob& job)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    KompareOverviewDensity density;
+    density.serial = job.serial;
+    density.entryIndex.reserve(job.entries.size());
+    for (int i = 0; i < job.entries.size(); ++i)
+        density.entryIndex.insert(job.entries[i].difference, i);
+
+    const int rows = job.size.height();
+    if (rows > 0 && job.size.width() > 0 && job.total > 0) {
+        density.weights.fill(0, rows * KompareOverviewRuler::Categories);
+        int first, last;
+        for (const KompareOverviewEntry& entry : job.entries)
+            addEntry(density.weights, rows, job.total, entry, 1, first, last);
+
+        density.image = QImage(job.size, QImage::Format_RGB32);
+        paintRows(density.image, density.weights, double(job.total) / rows, job.colors, job.base, 0, rows - 1);
+    }
+
+    density.buildTime = timer.nsecsElapsed();
+    return density;
+}
+
+KompareOverviewRuler::KompareOverviewRuler(ViewSettings* settings, QWidget* parent) :
+    QWidget(parent),
+    m_settings(settings),
+    m_total(0),
+    m_entriesSerial(0),
+    m_entryIndexSerial(0),
+    m_rebuildPending(false)
+{
+    m_density.serial = 0;
+    m_density.buildTime = 0;
+    setFixedWidth(OVERVIEW_WIDTH);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setCursor(Qt::PointingHandCursor);
+    connect(&m_watcher, &QFutureWatcher<KompareOverviewDensity>::finished, this, &KompareOverviewRuler::slotDensityBuilt);
+}
+
+KompareOverviewRuler::~KompareOverviewRuler()
+{
+    m_watcher.waitForFinished();
+}
+
+int KompareOverviewRuler::category(const Difference* diff)
+{
+    if (diff->applied())
+        return Applied;
+    switch (diff->type() & ~Difference::AppliedByBlend) {
+    case Difference::Insert: return Insert;
+    case Difference::Delete: return Delete;
+    default:                 return Change;
+    }
+}
+
+void KompareOverviewRuler::setEntries(const QVector<KompareOverviewEntry>& entries, qint64 total)
+{
+    m_entries = entries;
+    m_total = total;
+    ++m_entriesSerial;
+    m_changedBeforeIndex.clear();
+    rebuild();
+}
+
+void KompareOverviewRuler::rebuild()
+{
+    // one build at a time, the newest state is built when it finishes
+    if (m_watcher.isRunning()) {
+        m_rebuildPending = true;
+        return;
+    }
+
+    KompareOverviewJob job;
+    job.entries = m_entries;
+    job.total = m_total;
+    job.size = size() * devicePixelRatioF();
+    job.colors[Applied] = m_settings->m_appliedColor;
+    job.colors[Change] = m_settings->m_changeColor;
+    job.colors[Insert] = m_settings->m_addColor;
+    job.colors[Delete] = m_settings->m_removeColor;
+    job.base = palette().color(QPalette::Base);
+    job.serial = m_entriesSerial;
+    m_watcher.setFuture(QtConcurrent::run(buildDensity, job));
+}
+
+void KompareOverviewRuler::slotDensityBuilt()
+{
+    KompareOverviewDensity density = m_watcher.result();
+
+    if (density.serial == m_entriesSerial && m_entryIndexSerial != m_entriesSerial) {
+        m_entryIndex = density.entryIndex;
+        m_entryIndexSerial = density.serial;
+        // differences applied while the first build ran are only known now
+        for (const Difference* diff : qAsConst(m_changedBeforeIndex)) {
+            const int i = m_entryIndex.value(diff, -1);
+            if (i >= 0 && m_entries[i].category != category(diff)) {
+                m_entries[i].category = category(diff);
+                m_rebuildPending = true;
+            }
+        }
+        m_changedBeforeIndex.clear();
+    }
+
+    if (m_rebuildPending) {
+        m_rebuildPending = false;
+        rebuild();
+        return;
+    }
+
+    qCDebug(KOMPARERENDER) << "Built the overview of" << m_entries.size() << "differences in"
+                           << density.buildTime / 1000 << "us";
+    density.entryIndex.clear();
+    m_density = density;
+    update();
+}
+
+void KompareOverviewRuler::slotDifferenceChanged(const Difference* diff)
+{
+    if (m_entryIndexSerial != m_entriesSerial) {
+        m_changedBeforeIndex.insert(diff);
+        return;
+    }
+
+    const int i = m_entryIndex.value(diff, -1);
+    if (i < 0 || m_entries[i].category == category(diff))
+        return;
+
+    KompareOverviewEntry& entry = m_entries[i];
+    if (m_watcher.isRunning() || m_density.image.isNull()) {
+        entry.category = category(diff);
+        m_rebuildPending = m_watcher.isRunning();
+        return;
+    }
+
+    // Move the difference's share of its rows to the new category and recolor only those
+    const int rows = m_density.image.height();
+    int first, last;
+    addEntry(m_density.weights, rows, m_total, entry, -1, first, last);
+    entry.category = category(diff);
+    addEntry(m_density.weights, rows, m_total, entry, 1, first, last);
+
+    const QColor colors[Categories] = { m_settings->m_appliedColor, m_settings->m_changeColor,
+                                        m_settings->m_addColor, m_settings->m_removeColor };
+    paintRows(m_density.image, m_density.weights, double(m_total) / rows, colors, palette().color(QPalette::Base), first, last);
+
+    const qreal ratio = qreal(height()) / rows;
+    update(0, int(first * ratio), width(), int((last + 1) * ratio - first * ratio) + 1);
+}
+
+void KompareOverviewRuler::paintEvent(QPaintEvent* e)
+{
+    QPainter p(this);
+    if (m_density.image.isNull())
+        p.fillRect(e->rect(), palette().color(QPalette::Base));
+    else
+        p.drawImage(rect(), m_density.image);   // stretched while a resize is being built
+}
+
+void KompareOverviewRuler::resizeEvent(QResizeEvent* e)
+{
+    QWidget::resizeEvent(e);
+    rebuild();
+}
+
+void KompareOverviewRuler::mousePressEvent(QMouseEvent* e)
+{
+    if (e->button() == Qt::LeftButton)
+        scrollToRow(e->pos().y());
+}
+
+void KompareOverviewRuler::mouseMoveEvent(QMouseEvent* e)
+{
+    if (e->buttons() & Qt::LeftButton)
+        scrollToRow(e->pos().y());
+}
+
+void KompareOverviewRuler::scrollToRow(int y)
+{
+    if (m_total <= 0 || height() <= 0)
+        return;
+
+    // scroll ids are at the middle of the view, the clicked row ends up there
+    const int row = qBound(0, y, height() - 1);
+    emit scrollToId(qint64((row + 0.5) * double(m_total) / height()));
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+                                kompareoverviewruler.h
+                                ----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPAREOVERVIEWRULER_H
+#define KOMPAREOVERVIEWRULER_H
+
+#include <QColor>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QSet>
+#include <QVector>
+#include <QWidget>
+
+namespace Diff2 {
+class Difference;
+}
+class ViewSettings;
+
+/** A changed difference as the ruler sees it, in scroll id space */
+struct KompareOverviewEntry
+{
+    const Diff2::Difference* difference; // only used as a key, never read by the worker
+    qint64                   top;
+    qint64                   height;
+    int                      category;   // see KompareOverviewRuler::Category
+};
+
+/** What the worker builds: how much of every row each category covers, and the rows painted */
+struct KompareOverviewDensity
+{
+    QVector<float>                        weights;  // Categories per row
+    QImage                                image;
+    QHash<const Diff2::Difference*, int>  entryIndex;
+    int                                   serial;   // of the entries it was built from
+    qint64                                buildTime;
+};
+
+/**
+ * A narrow strip beside the vertical scroll bar showing where the changes
+ * of the whole model are. Clicking or dragging in it scrolls there.
+ *
+ * Every pixel row covers an equal slice of the scroll id space. The rows
+ * are built on a worker thread from a snapshot of the changed differences,
+ * applying a single difference afterwards only recolors the rows it covers.
+ */
+class KompareOverviewRuler : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Category { Applied = 0, Change, Insert, Delete, Categories };
+
+    KompareOverviewRuler(ViewSettings* settings, QWidget* parent);
+    ~KompareOverviewRuler() override;
+
+    /** Replaces everything shown, total is the height of the model in scroll ids */
+    void setEntries(const QVector<KompareOverviewEntry>& entries, qint64 total);
+
+    static int category(const Diff2::Difference* diff);
+
+public Q_SLOTS:
+    /** Recolors the rows of diff after it was applied or unapplied */
+    void slotDifferenceChanged(const Diff2::Difference* diff);
+
+Q_SIGNALS:
+    void scrollToId(qint64 id);
+
+protected:
+    void paintEvent(QPaintEvent* e) override;
+    void resizeEvent(QResizeEvent* e) override;
+    void mousePressEvent(QMouseEvent* e) override;
+    void mouseMoveEvent(QMouseEvent* e) override;
+
+private Q_SLOTS:
+    void slotDensityBuilt();
+
+private:
+    void rebuild();
+    void scrollToRow(int y);
+
+    ViewSettings*                           m_settings;
+
+    QVector<KompareOverviewEntry>           m_entries;
+    qint64                                  m_total;
+    int                                     m_entriesSerial;
+
+    // Where every difference is in m_entries, comes with the first build of new entries
+    QHash<const Diff2::Difference*, int>    m_entryIndex;
+    int                                     m_entryIndexSerial;
+    QSet<const Diff2::Difference*>          m_changedBeforeIndex;
+
+    // The last finished build, m_density.image is what is painted
+    KompareOverviewDensity                  m_density;
+    QFutureWatcher<KompareOverviewDensity>  m_watcher;
+    bool                                    m_rebuildPending;
+};
+
+#endif
@@ -22,7 +22,7 @@
 #include <KPageDialog>
 
 class DiffPage;
-class DiffSettings;
+class KompareDiffSettings;
 class ViewPage;
 class ViewSettings;
 
@@ -30,7 +30,7 @@ class KomparePrefDlg : public KPageDialog
 {
     Q_OBJECT
 public:
-    KomparePrefDlg(ViewSettings*, DiffSettings*);
+    KomparePrefDlg(ViewSettings*, KompareDiffSettings*);
     ~KomparePrefDlg() override;
 
 protected Q_SLOTS:
@@ -0,0 +1,76 @@
+/***************************************************************************
+                                komparescrollgeometry.cpp
+                                -------------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparescrollgeometry.h"
+
+#include <QtGlobal>
+
+bool KompareScrollGeometry::Pane::operator==(const Pane& other) const
+{
+    return contentsWidth == other.contentsWidth &&
+           contentsHeight == other.contentsHeight &&
+           visibleWidth == other.visibleWidth &&
+           pageSize == other.pageSize &&
+           contentsX == other.contentsX &&
+           minScrollId == other.minScrollId &&
+           maxScrollId == other.maxScrollId;
+}
+
+KompareScrollGeometry::KompareScrollGeometry() :
+    m_maxContentsHeight(0),
+    m_minVScrollId(0),
+    m_maxVScrollId(0),
+    m_maxHScrollId(0),
+    m_maxContentsX(0),
+    m_minVisibleWidth(0),
+    m_pageSize(1)
+{
+}
+
+bool KompareScrollGeometry::setPane(const void* pane, const Pane& geometry)
+{
+    QHash<const void*, Pane>::Iterator it = m_panes.find(pane);
+    if (it != m_panes.end() && *it == geometry)
+        return false;
+    m_panes.insert(pane, geometry);
+
+    // There are only ever a handful of panes, combining them is cheap
+    m_maxContentsHeight = 0;
+    m_minVScrollId = -1;
+    m_maxVScrollId = 0;
+    m_maxHScrollId = 0;
+    m_maxContentsX = 0;
+    m_minVisibleWidth = -1;
+    m_pageSize = -1;
+    for (const Pane& p : qAsConst(m_panes)) {
+        m_maxContentsHeight = qMax(m_maxContentsHeight, p.contentsHeight);
+        if (p.minScrollId < m_minVScrollId || m_minVScrollId == -1)
+            m_minVScrollId = p.minScrollId;
+        m_maxVScrollId = qMax(m_maxVScrollId, p.maxScrollId);
+        m_maxHScrollId = qMax(m_maxHScrollId, p.contentsWidth - p.visibleWidth);
+        m_maxContentsX = qMax(m_maxContentsX, p.contentsX);
+        if (p.visibleWidth < m_minVisibleWidth || m_minVisibleWidth == -1)
+            m_minVisibleWidth = p.visibleWidth;
+        // the panes share the splitter's height, a page is what the lowest one shows
+        if (p.pageSize < m_pageSize || m_pageSize == -1)
+            m_pageSize = p.pageSize;
+    }
+    m_minVScrollId = qMax(m_minVScrollId, 0);
+    m_minVisibleWidth = qMax(m_minVisibleWidth, 0);
+    m_pageSize = qMax(m_pageSize, 1);
+
+    return true;
+}
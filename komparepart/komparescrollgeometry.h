@@ -0,0 +1,72 @@
+/***************************************************************************
+                                komparescrollgeometry.h
+                                -----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPARESCROLLGEOMETRY_H
+#define KOMPARESCROLLGEOMETRY_H
+
+#include <QHash>
+#include <QtGlobal>
+
+/**
+ * The scroll geometry of all panes of a splitter.
+ *
+ * Every pane publishes its extents when its content or viewport changes,
+ * the combined values the splitter sets its scroll bars from are kept up
+ * to date here so reading them does not visit the panes.
+ */
+class KompareScrollGeometry
+{
+public:
+    struct Pane {
+        int    contentsWidth;
+        qint64 contentsHeight;
+        int    visibleWidth;
+        int    pageSize;
+        int    contentsX;
+        int    minScrollId;
+        qint64 maxScrollId;
+
+        bool operator==(const Pane& other) const;
+        bool operator!=(const Pane& other) const { return !(*this == other); };
+    };
+
+    KompareScrollGeometry();
+
+    /** Returns true when the combined geometry changed */
+    bool setPane(const void* pane, const Pane& geometry);
+
+    bool   needVScrollBar() const { return m_maxContentsHeight > m_pageSize; };
+    int    minVScrollId() const { return m_minVScrollId; };
+    qint64 maxVScrollId() const { return m_maxVScrollId; };
+    bool   needHScrollBar() const { return m_maxHScrollId > 0; };
+    int    maxHScrollId() const { return m_maxHScrollId; };
+    int    maxContentsX() const { return m_maxContentsX; };
+    int    minVisibleWidth() const { return m_minVisibleWidth; };
+    int    pageSize() const { return m_pageSize; };
+
+private:
+    QHash<const void*, Pane> m_panes;
+
+    qint64 m_maxContentsHeight;
+    int    m_minVScrollId;
+    qint64 m_maxVScrollId;
+    int    m_maxHScrollId;
+    int    m_maxContentsX;
+    int    m_minVisibleWidth;
+    int    m_pageSize;
+};
+
+#endif
@@ -0,0 +1,295 @@
+/***************************************************************************
+                                komparesearch.cpp
+                                -----------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparesearch.h"
+
+#include <algorithm>
+
+#include <QElapsedTimer>
+#include <QFutureInterface>
+#include <QRegularExpression>
+#include <QStringMatcher>
+#include <QtConcurrent>
+
+#include <libkomparediff2/diffhunk.h>
+#include <libkomparediff2/diffmodel.h>
+#include <libkomparediff2/difference.h>
+
+#include <komparepartdebug.h>
+
+// searching stops after this many hits
+#define MAX_HITS 100000
+// hits are handed to the GUI thread this many at a time
+#define HIT_BATCH 256
+// a hit keeps this many characters of its line, starting a little before the match
+#define EXCERPT_LENGTH 200
+#define EXCERPT_LEAD 40
+
+using namespace Diff2;
+
+struct KompareSearchLine
+{
+    const Difference* difference;
+    int               line;
+    int               sourceLineNumber;
+    int               destinationLineNumber;
+};
+
+/**
+ * The lines of one model and where they come from. The index is built on
+ * the worker by the first search of the model, there is never more than
+ * one search running and the part cancels it before the models change.
+ */
+struct KompareSearchIndex
+{
+    // unchanged lines are the same on both sides, they are kept once
+    enum Part { Destination, Source, Context, Parts };
+
+    const DiffModel*            model;
+    bool                        built;
+    QVector<KompareSearchLine>  lines[Parts];
+    QVector<QString>            texts[Parts];
+
+    QString                     text[Parts];
+    QVector<int>                starts[Parts]; // of every line in text
+};
+
+typedef QVector<QSharedPointer<KompareSearchIndex> > KompareSearchIndexes;
+
+// Only the strings are copied, they share their data with the model
+static bool buildIndex(KompareSearchIndex& index, const QFutureInterface<KompareSearchHit>& future)
+{
+    for (int part = 0; part < KompareSearchIndex::Parts; ++part) {
+        index.lines[part].clear();
+        index.texts[part].clear();
+        index.text[part].clear();
+        index.starts[part].clear();
+    }
+
+    DiffHunkListConstIterator hunkIt = index.model->hunks()->begin();
+    DiffHunkListConstIterator hEnd   = index.model->hunks()->end();
+    for (; hunkIt != hEnd; ++hunkIt)
+    {
+        if (future.isCanceled())
+            return false;
+
+        DifferenceListConstIterator diffIt = (*hunkIt)->differences().begin();
+        DifferenceListConstIterator dEnd   = (*hunkIt)->differences().end();
+        for (; diffIt != dEnd; ++diffIt)
+        {
+            const Difference* diff = *diffIt;
+            const bool unchanged = diff->type() == Difference::Unchanged;
+            const int source = unchanged ? KompareSearchIndex::Context : KompareSearchIndex::Source;
+            for (int i = 0; i < diff->sourceLineCount(); ++i) {
+                index.lines[source].append({ diff, i, diff->sourceLineNumber() + i, diff->destinationLineNumber() + i });
+                index.texts[source].append(diff->sourceLineAt(i)->string());
+            }
+            if (unchanged)
+                continue;
+            for (int i = 0; i < diff->destinationLineCount(); ++i) {
+                index.lines[KompareSearchIndex::Destination].append({ diff, i, diff->sourceLineNumber() + i, diff->destinationLineNumber() + i });
+                index.texts[KompareSearchIndex::Destination].append(diff->destinationLineAt(i)->string());
+            }
+        }
+    }
+
+    index.built = true;
+    return true;
+}
+
+static void joinLines(KompareSearchIndex& index, int part)
+{
+    const QVector<QString>& texts = index.texts[part];
+    int length = 0;
+    for (const QString& text : texts)
+        length += text.size() + 1;
+
+    QString& joined = index.text[part];
+    QVector<int>& starts = index.starts[part];
+    joined.reserve(length);
+    starts.reserve(texts.size());
+    for (const QString& text : texts) {
+        starts.append(joined.size());
+        joined += text;
+        joined += QLatin1Char('\n');
+    }
+}
+
+static void reportHits(QFutureInterface<KompareSearchHit>& future, QVector<KompareSearchHit>& hits)
+{
+    if (!hits.isEmpty())
+        future.reportResults(hits);
+    hits.clear();
+}
+
+static bool reportHit(QFutureInterface<KompareSearchHit>& future, QVector<KompareSearchHit>& hits,
+                      const KompareSearchIndex& index, int part, bool source, int position, int length, int& hitCount)
+{
+    const QVector<int>& starts = index.starts[part];
+    const int i = std::upper_bound(starts.constBegin(), starts.constEnd(), position) - starts.constBegin() - 1;
+    const KompareSearchLine& line = index.lines[part][i];
+    const QString& text = index.texts[part][i];
+
+    KompareSearchHit hit;
+    hit.model = index.model;
+    hit.difference = line.difference;
+    hit.source = source;
+    hit.line = line.line;
+    hit.lineNumber = source ? line.sourceLineNumber : line.destinationLineNumber;
+    hit.column = position - starts[i];
+    // a regular expression match may run into the next lines, only this one is shown
+    hit.length = qMin(length, text.size() - hit.column);
+    // a minified or generated file can have lines of megabytes, keep only the part around the hit
+    const int begin = qMax(0, hit.column - EXCERPT_LEAD);
+    hit.text = text.mid(begin, EXCERPT_LENGTH);
+    if (begin > 0)
+        hit.text.prepend(QChar(0x2026));
+    if (begin + EXCERPT_LENGTH < text.size())
+        hit.text.append(QChar(0x2026));
+    hits.append(hit);
+    if (hits.size() == HIT_BATCH)
+        reportHits(future, hits);
+
+    return ++hitCount < MAX_HITS && !future.isCanceled();
+}
+
+static void search(QFutureInterface<KompareSearchHit> future, const KompareSearchIndexes& indexes, const KompareSearchOptions& options)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const Qt::CaseSensitivity cs = options.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    const QStringMatcher matcher(options.pattern, cs);
+    QRegularExpression::PatternOptions patternOptions = QRegularExpression::MultilineOption;
+    if (!options.caseSensitive)
+        patternOptions |= QRegularExpression::CaseInsensitiveOption;
+    const QRegularExpression expression(options.pattern, patternOptions);
+
+    QVector<KompareSearchHit> hits;
+    hits.reserve(HIT_BATCH);
+    int hitCount = 0;
+    bool more = !options.pattern.isEmpty() && (!options.regularExpression || expression.isValid());
+
+    for (int i = 0; more && i < indexes.size(); ++i) {
+        KompareSearchIndex& index = *indexes[i];
+        if (!index.built && !buildIndex(index, future))
+            break;
+        for (int part = KompareSearchIndex::Destination; more && part < KompareSearchIndex::Parts; ++part) {
+            if (part == KompareSearchIndex::Destination && !(options.scope & KompareSearchOptions::Destination))
+                continue;
+            if (part == KompareSearchIndex::Source && !(options.scope & KompareSearchOptions::Source))
+                continue;
+            // context hits are shown in the source pane unless only the destination is searched
+            const bool source = part == KompareSearchIndex::Source ||
+                                (part == KompareSearchIndex::Context && (options.scope & KompareSearchOptions::Source));
+
+            if (index.starts[part].isEmpty() && !index.texts[part].isEmpty())
+                joinLines(index, part);
+
+            const QString& text = index.text[part];
+            if (options.regularExpression) {
+                QRegularExpressionMatchIterator it = expression.globalMatch(text);
+                while (more && it.hasNext()) {
+                    const QRegularExpressionMatch match = it.next();
+                    // a pattern like "a*" matches nothing everywhere
+                    if (match.capturedLength() == 0)
+                        more = !future.isCanceled();
+                    else
+                        more = reportHit(future, hits, index, part, source, match.capturedStart(), match.capturedLength(), hitCount);
+                }
+            } else {
+                for (int position = matcher.indexIn(text, 0); more && position >= 0;
+                     position = matcher.indexIn(text, position + options.pattern.size()))
+                    more = reportHit(future, hits, index, part, source, position, options.pattern.size(), hitCount);
+            }
+            more = more && !future.isCanceled();
+        }
+    }
+
+    reportHits(future, hits);
+    qCDebug(KOMPAREPART) << "Found" << hitCount << "hits in" << indexes.size() << "models in" << timer.elapsed() << "ms";
+    future.reportFinished();
+}
+
+KompareSearch::KompareSearch(QObject* parent) :
+    QObject(parent)
+{
+    connect(&m_watcher, &QFutureWatcherBase::resultsReadyAt, this, &KompareSearch::slotResultsReady);
+    connect(&m_watcher, &QFutureWatcherBase::finished, this, &KompareSearch::slotFinished);
+}
+
+KompareSearch::~KompareSearch()
+{
+    cancel();
+}
+
+QSharedPointer<KompareSearchIndex> KompareSearch::index(const DiffModel* model)
+{
+    QSharedPointer<KompareSearchIndex> index = m_indexes.value(model);
+    if (index)
+        return index;
+
+    // the worker fills it in when it gets to the model
+    index.reset(new KompareSearchIndex);
+    index->model = model;
+    index->built = false;
+    m_indexes.insert(model, index);
+    return index;
+}
+
+void KompareSearch::start(const DiffModelList* models, const KompareSearchOptions& options)
+{
+    cancel();
+
+    KompareSearchIndexes indexes;
+    if (models) {
+        for (const DiffModel* model : *models)
+            indexes.append(index(model));
+    }
+
+    QFutureInterface<KompareSearchHit> future;
+    future.reportStarted();
+    m_watcher.setFuture(future.future());
+    QtConcurrent::run(search, future, indexes, options);
+}
+
+void KompareSearch::cancel()
+{
+    if (m_watcher.isRunning()) {
+        m_watcher.cancel();
+        m_watcher.waitForFinished();
+    }
+}
+
+void KompareSearch::slotModelsChanged()
+{
+    cancel();
+    m_indexes.clear();
+}
+
+void KompareSearch::slotResultsReady(int begin, int end)
+{
+    QVector<KompareSearchHit> hits;
+    hits.reserve(end - begin);
+    for (int i = begin; i < end; ++i)
+        hits.append(m_watcher.resultAt(i));
+    emit hitsFound(hits);
+}
+
+void KompareSearch::slotFinished()
+{
+    emit finished(m_watcher.future().resultCount(), m_watcher.isCanceled());
+}
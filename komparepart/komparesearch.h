@@ -0,0 +1,108 @@
+/***************************************************************************
+                                komparesearch.h
+                                ---------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPARESEARCH_H
+#define KOMPARESEARCH_H
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <libkomparediff2/komparemodellist.h>
+
+namespace Diff2 {
+class DiffModel;
+class Difference;
+}
+
+struct KompareSearchOptions
+{
+    enum Scope { Source = 1, Destination = 2, Both = Source | Destination };
+
+    QString pattern;
+    bool    regularExpression;
+    bool    caseSensitive;
+    Scope   scope;
+};
+
+/**
+ * One occurrence of the pattern. Column and length are in characters of the
+ * whole line, text is only an excerpt of it around the match, with an
+ * ellipsis where the line was cut.
+ */
+struct KompareSearchHit
+{
+    const Diff2::DiffModel*   model;
+    const Diff2::Difference*  difference;
+    bool                      source;
+    int                       line;       // in the difference
+    int                       lineNumber; // in the file
+    int                       column;
+    int                       length;
+    QString                   text;
+};
+
+struct KompareSearchIndex;
+
+/**
+ * Finds a substring or a regular expression in the source and destination
+ * lines of all models.
+ *
+ * The lines of a model are collected once into an index that is kept until
+ * the models change, so searching it again does not walk the model. Both
+ * run on a worker thread, which hands out the hits in batches as they are
+ * found. The search has to be cancelled before the models are deleted.
+ *
+ * Unchanged lines read the same on both sides, so a hit in one is reported
+ * once, for the source side, or for the destination side when only that is
+ * searched. Reporting it for both would list every context hit twice.
+ */
+class KompareSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KompareSearch(QObject* parent = nullptr);
+    ~KompareSearch() override;
+
+    /** Starts a new search over models, a running one is cancelled */
+    void start(const Diff2::DiffModelList* models, const KompareSearchOptions& options);
+    void cancel();
+    bool isRunning() const { return m_watcher.isRunning(); }
+
+public Q_SLOTS:
+    /** The indexed models are gone */
+    void slotModelsChanged();
+
+Q_SIGNALS:
+    void hitsFound(const QVector<KompareSearchHit>& hits);
+    void finished(int hitCount, bool cancelled);
+
+private Q_SLOTS:
+    void slotResultsReady(int begin, int end);
+    void slotFinished();
+
+private:
+    QSharedPointer<KompareSearchIndex> index(const Diff2::DiffModel* model);
+
+    QHash<const Diff2::DiffModel*, QSharedPointer<KompareSearchIndex> > m_indexes;
+    QFutureWatcher<KompareSearchHit>                                    m_watcher;
+};
+
+#endif
@@ -0,0 +1,146 @@
+/***************************************************************************
+                                komparesearchdialog.cpp
+                                -----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparesearchdialog.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <KLocalizedString>
+
+#include <libkomparediff2/diffmodel.h>
+
+using namespace Diff2;
+
+KompareSearchDialog::KompareSearchDialog(QWidget* parent) :
+    QDialog(parent)
+{
+    setObjectName(QStringLiteral("find"));
+    setWindowTitle(i18n("Find"));
+
+    m_pattern = new QLineEdit(this);
+    m_pattern->setPlaceholderText(i18n("Text to find"));
+    m_pattern->setClearButtonEnabled(true);
+
+    m_scope = new QComboBox(this);
+    m_scope->addItem(i18n("Source and Destination"), KompareSearchOptions::Both);
+    m_scope->addItem(i18n("Source"), KompareSearchOptions::Source);
+    m_scope->addItem(i18n("Destination"), KompareSearchOptions::Destination);
+
+    m_caseSensitive = new QCheckBox(i18n("C&ase sensitive"), this);
+    m_regularExpression = new QCheckBox(i18n("&Regular expression"), this);
+
+    m_results = new QTreeWidget(this);
+    m_results->setRootIsDecorated(false);
+    m_results->setUniformRowHeights(true);
+    m_results->setHeaderLabels(QStringList() << i18n("File") << i18n("Line") << i18n("Text"));
+    m_results->header()->setStretchLastSection(true);
+
+    m_status = new QLabel(this);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    m_find = buttons->addButton(i18n("&Find"), QDialogButtonBox::ActionRole);
+    m_find->setDefault(true);
+
+    QHBoxLayout* options = new QHBoxLayout;
+    options->addWidget(m_scope);
+    options->addWidget(m_caseSensitive);
+    options->addWidget(m_regularExpression);
+    options->addStretch();
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(m_pattern);
+    layout->addLayout(options);
+    layout->addWidget(m_results);
+    layout->addWidget(m_status);
+    layout->addWidget(buttons);
+
+    connect(m_find, &QPushButton::clicked, this, &KompareSearchDialog::slotFind);
+    connect(m_pattern, &QLineEdit::returnPressed, this, &KompareSearchDialog::slotFind);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(m_results, &QTreeWidget::itemActivated, this, &KompareSearchDialog::slotItemActivated);
+
+    resize(600, 400);
+}
+
+KompareSearchDialog::~KompareSearchDialog()
+{
+}
+
+void KompareSearchDialog::slotFind()
+{
+    m_hits.clear();
+    m_results->clear();
+    m_status->setText(i18n("Searching..."));
+
+    KompareSearchOptions options;
+    options.pattern = m_pattern->text();
+    options.regularExpression = m_regularExpression->isChecked();
+    options.caseSensitive = m_caseSensitive->isChecked();
+    options.scope = static_cast<KompareSearchOptions::Scope>(m_scope->currentData().toInt());
+    emit searchRequested(options);
+}
+
+void KompareSearchDialog::slotHitsFound(const QVector<KompareSearchHit>& hits)
+{
+    // hits come in batches, add each batch in one go
+    QList<QTreeWidgetItem*> items;
+    items.reserve(hits.size());
+    for (const KompareSearchHit& hit : hits) {
+        QTreeWidgetItem* item = new QTreeWidgetItem;
+        item->setText(0, hit.source ? hit.model->sourceFile() : hit.model->destinationFile());
+        item->setText(1, QString::number(hit.lineNumber));
+        item->setText(2, hit.text.trimmed());
+        item->setData(0, Qt::UserRole, m_hits.size());
+        m_hits.append(hit);
+        items.append(item);
+    }
+    m_results->addTopLevelItems(items);
+    m_status->setText(i18np("Searching... %1 match", "Searching... %1 matches", m_hits.size()));
+}
+
+void KompareSearchDialog::slotFinished(int hitCount, bool cancelled)
+{
+    if (cancelled)
+        return;
+    if (hitCount)
+        m_status->setText(i18np("%1 match", "%1 matches", hitCount));
+    else
+        m_status->setText(i18n("No matches"));
+}
+
+void KompareSearchDialog::slotModelsChanged()
+{
+    // the hits point into the old models
+    m_hits.clear();
+    m_results->clear();
+    m_status->clear();
+}
+
+void KompareSearchDialog::slotItemActivated(QTreeWidgetItem* item)
+{
+    const int i = item->data(0, Qt::UserRole).toInt();
+    if (i >= 0 && i < m_hits.size())
+        emit hitActivated(m_hits[i]);
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+                                komparesearchdialog.h
+                                ---------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPARESEARCHDIALOG_H
+#define KOMPARESEARCHDIALOG_H
+
+#include <QDialog>
+#include <QVector>
+
+#include "komparesearch.h"
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+/**
+ * Asks for what to find and lists the hits while they come in.
+ * Activating a hit asks the part to show it.
+ */
+class KompareSearchDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit KompareSearchDialog(QWidget* parent);
+    ~KompareSearchDialog() override;
+
+public Q_SLOTS:
+    void slotHitsFound(const QVector<KompareSearchHit>& hits);
+    void slotFinished(int hitCount, bool cancelled);
+    void slotModelsChanged();
+
+Q_SIGNALS:
+    void searchRequested(const KompareSearchOptions& options);
+    void hitActivated(const KompareSearchHit& hit);
+
+private Q_SLOTS:
+    void slotFind();
+    void slotItemActivated(QTreeWidgetItem* item);
+
+private:
+    QLineEdit*                m_pattern;
+    QComboBox*                m_scope;
+    QCheckBox*                m_caseSensitive;
+    QCheckBox*                m_regularExpression;
+    QPushButton*              m_find;
+    QTreeWidget*              m_results;
+    QLabel*                   m_status;
+
+    QVector<KompareSearchHit> m_hits;
+};
+
+#endif
@@ -34,6 +34,9 @@
 #include <QChildEvent>
 #include <QEvent>
 #include <QWheelEvent>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWindow>
 
 // kde
 
@@ -41,14 +44,22 @@
 #include "komparelistview.h"
 #include "viewsettings.h"
 #include "kompareconnectwidget.h"
+#include "kompareoverviewruler.h"
+#include "komparerenderdebug.h"
 #include <libkomparediff2/diffmodel.h>
 #include <libkomparediff2/difference.h>
 
 using namespace Diff2;
 
+#define FRAME_TIME_BUCKETS 7
+
+// the largest range given to the vertical QScrollBar
+#define VSCROLL_RANGE (1 << 30)
+
 KompareSplitter::KompareSplitter(ViewSettings* settings, QWidget* parent) :
     QSplitter(Qt::Horizontal, parent),
-    m_settings(settings)
+    m_settings(settings),
+    m_highlighter(settings)
 {
     QFrame* scrollFrame = static_cast<QFrame*>(parent);
 
@@ -62,6 +73,9 @@ KompareSplitter::KompareSplitter(ViewSettings* settings, QWidget* parent) :
     pairlayout->addWidget(m_vScroll, 0, 1);
     m_hScroll = new QScrollBar(Qt::Horizontal, scrollFrame);
     pairlayout->addWidget(m_hScroll, 1, 0);
+    m_overview = new KompareOverviewRuler(m_settings, scrollFrame);
+    pairlayout->addWidget(m_overview, 0, 2);
+    m_overviewModel = nullptr;
 
     new KompareListViewFrame(true, m_settings, this, "source");
     new KompareListViewFrame(false, m_settings, this, "destination");
@@ -82,14 +96,25 @@ KompareSplitter::KompareSplitter(ViewSettings* settings, QWidget* parent) :
     connect(this, &KompareSplitter::configChanged, this, &KompareSplitter::slotDelayedUpdateScrollBars);
 
     // scrolling
-    connect(m_vScroll, &QScrollBar::valueChanged, this, &KompareSplitter::slotScrollToId);
-    connect(m_vScroll, &QScrollBar::sliderMoved,  this, &KompareSplitter::slotScrollToId);
-    connect(m_hScroll, &QScrollBar::valueChanged, this, &KompareSplitter::setXOffset);
-    connect(m_hScroll, &QScrollBar::sliderMoved,  this, &KompareSplitter::setXOffset);
-
-    m_scrollTimer = new QTimer(this);
-    m_restartTimer = false;
-    connect(m_scrollTimer, &QTimer::timeout, this, &KompareSplitter::timerTimeout);
+    connect(m_vScroll, &QScrollBar::valueChanged, this, &KompareSplitter::slotVScrollValueChanged);
+    connect(m_vScroll, &QScrollBar::sliderMoved,  this, &KompareSplitter::slotVScrollValueChanged);
+    connect(m_hScroll, &QScrollBar::valueChanged, this, &KompareSplitter::slotScrollToX);
+    connect(m_hScroll, &QScrollBar::sliderMoved,  this, &KompareSplitter::slotScrollToX);
+    connect(m_overview, &KompareOverviewRuler::scrollToId, this, &KompareSplitter::slotScrollToId);
+
+    // all scrolling and handle repaints are applied once per display frame
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setSingleShot(true);
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    m_scrollTo = 0;
+    m_vScrollScale = 1;
+    m_xTo = 0;
+    m_scrollPending = false;
+    m_xPending = false;
+    m_repaintHandlesPending = false;
+    m_frameTimes.fill(0, FRAME_TIME_BUCKETS);
+    m_frameCount = 0;
+    connect(m_frameTimer, &QTimer::timeout, this, &KompareSplitter::slotFrame);
 
     // we need to receive childEvents now so that d->list is ready for when
     // slotSetSelection(...) arrives
@@ -110,7 +135,8 @@ QSplitterHandle* KompareSplitter::createHandle()
 
 void KompareSplitter::slotDelayedRepaintHandles()
 {
-    QTimer::singleShot(0, this, &KompareSplitter::slotRepaintHandles);
+    m_repaintHandlesPending = true;
+    scheduleFrame();
 }
 
 void KompareSplitter::slotRepaintHandles()
@@ -120,38 +146,109 @@ void KompareSplitter::slotRepaintHandles()
         handle(i)->update();
 }
 
-void KompareSplitter::timerTimeout()
+void KompareSplitter::slotVScrollValueChanged(int value)
 {
-    if (m_restartTimer)
-        m_restartTimer = false;
-    else
-        m_scrollTimer->stop();
+    slotScrollToId(m_scrollGeometry.minVScrollId() + value * m_vScrollScale);
+}
 
-    slotDelayedRepaintHandles();
+int KompareSplitter::vScrollValue(qint64 id) const
+{
+    return int((id - m_scrollGeometry.minVScrollId()) / m_vScrollScale);
+}
 
-    emit scrollViewsToId(m_scrollTo);
-    slotRepaintHandles();
-    m_vScroll->setValue(m_scrollTo);
+void KompareSplitter::scrollVertically(qint64 delta)
+{
+    // in scroll ids, the scroll bar may be too coarse for single steps
+    const qint64 from = m_scrollPending ? m_scrollTo : scrollId();
+    slotScrollToId(qBound<qint64>(m_scrollGeometry.minVScrollId(), from + delta, m_scrollGeometry.maxVScrollId()));
 }
 
-void KompareSplitter::slotScrollToId(int id)
+void KompareSplitter::slotScrollToId(qint64 id)
 {
     m_scrollTo = id;
+    m_scrollPending = true;
+    scheduleFrame();
+}
 
-    if (m_restartTimer)
+void KompareSplitter::scrollToLine(const Difference* diff, bool source, int line)
+{
+    const int end = count();
+    for (int i = 0; i < end; ++i) {
+        if (listView(i)->isSource() != source)
+            continue;
+        const qint64 id = listView(i)->lineScrollId(diff, line);
+        if (id >= 0)
+            slotScrollToId(qBound<qint64>(m_scrollGeometry.minVScrollId(), id, m_scrollGeometry.maxVScrollId()));
         return;
+    }
+}
 
-    if (m_scrollTimer->isActive())
+void KompareSplitter::slotScrollToX(int x)
+{
+    m_xTo = x;
+    m_xPending = true;
+    scheduleFrame();
+}
+
+int KompareSplitter::frameInterval()
+{
+    const QWindow* window = this->window()->windowHandle();
+    const QScreen* screen = window ? window->screen() : QGuiApplication::primaryScreen();
+    const qreal rate = screen ? screen->refreshRate() : 0;
+    return qRound(1000.0 / (rate >= 1 ? rate : 60));
+}
+
+void KompareSplitter::scheduleFrame()
+{
+    if (m_frameTimer->isActive())
+        return;
+
+    // right away after a pause, otherwise one frame after the last one
+    const qint64 sinceLastFrame = m_lastFrame.isValid() ? m_lastFrame.elapsed() : frameInterval();
+    m_frameTimer->start(qMax<qint64>(0, frameInterval() - sinceLastFrame));
+}
+
+void KompareSplitter::slotFrame()
+{
+    // Only continuous scrolling counts, not the first frame after a pause
+    if (m_lastFrame.isValid() && m_lastFrame.elapsed() < 4 * frameInterval())
+        recordFrameTime(m_lastFrame.elapsed());
+    m_lastFrame.start();
+
+    if (m_scrollPending)
     {
-        m_restartTimer = true;
+        m_scrollPending = false;
+        emit scrollViewsToId(m_scrollTo);
+        m_vScroll->blockSignals(true);
+        m_vScroll->setValue(vScrollValue(m_scrollTo));
+        m_vScroll->blockSignals(false);
+        m_repaintHandlesPending = true;
     }
-    else
+
+    if (m_xPending)
     {
-        emit scrollViewsToId(id);
+        m_xPending = false;
+        emit setXOffset(m_xTo);
+    }
+
+    if (m_repaintHandlesPending)
+    {
+        m_repaintHandlesPending = false;
         slotRepaintHandles();
-        m_vScroll->setValue(id);
-        m_scrollTimer->start(30);
     }
+    // nothing is scheduled until the next input arrives
+}
+
+void KompareSplitter::recordFrameTime(qint64 msecs)
+{
+    // buckets of up to 1, 2, 4, ... ms, the last one takes the rest
+    int bucket = 0;
+    while (bucket < FRAME_TIME_BUCKETS - 1 && msecs > (1 << bucket))
+        ++bucket;
+    ++m_frameTimes[bucket];
+
+    if (++m_frameCount % 240 == 0)
+        qCDebug(KOMPARERENDER) << "Frame times up to 1, 2, 4 ... ms:" << m_frameTimes;
 }
 
 void KompareSplitter::slotDelayedUpdateScrollBars()
@@ -161,28 +258,24 @@ void KompareSplitter::slotDelayedUpdateScrollBars()
 
 void KompareSplitter::slotUpdateScrollBars()
 {
-    const int end = count();
-    for (int i = 0; i < end; ++i) {
-        KompareListView* lv = listView(i);
-        int minHScroll = minHScrollId();
-        if (lv->contentsX() < minHScroll) {
-            lv->setXOffset(minHScroll);
-        }
-    }
+    // the panes keep m_scrollGeometry up to date, nothing here visits them
+    int m_scrollDistance = scrollDistance();
+    int m_pageSize = m_scrollGeometry.pageSize();
 
-    int m_scrollDistance = m_settings->m_scrollNoOfLines * lineHeight();
-    int m_pageSize = pageSize();
-
-    if (needVScrollBar())
+    if (m_scrollGeometry.needVScrollBar())
     {
         m_vScroll->show();
 
+        // Scroll ids are 64-bit, QScrollBar only has an int range. Huge
+        // files get a scroll bar whose steps span several scroll ids.
+        const qint64 range = m_scrollGeometry.maxVScrollId() - m_scrollGeometry.minVScrollId();
+        m_vScrollScale = range / VSCROLL_RANGE + 1;
+
         m_vScroll->blockSignals(true);
-        m_vScroll->setRange(minVScrollId(),
-                            maxVScrollId());
-        m_vScroll->setValue(scrollId());
-        m_vScroll->setSingleStep(m_scrollDistance);
-        m_vScroll->setPageStep(m_pageSize);
+        m_vScroll->setRange(0, vScrollValue(m_scrollGeometry.maxVScrollId()));
+        m_vScroll->setValue(vScrollValue(scrollId()));
+        m_vScroll->setSingleStep(qMax<qint64>(1, m_scrollDistance / m_vScrollScale));
+        m_vScroll->setPageStep(qMax<qint64>(1, m_pageSize / m_vScrollScale));
         m_vScroll->blockSignals(false);
     }
     else
@@ -190,14 +283,16 @@ void KompareSplitter::slotUpdateScrollBars()
         m_vScroll->hide();
     }
 
-    if (needHScrollBar())
+    if (m_scrollGeometry.needHScrollBar())
     {
         m_hScroll->show();
         m_hScroll->blockSignals(true);
-        m_hScroll->setRange(minHScrollId(), maxHScrollId());
-        m_hScroll->setValue(maxContentsX());
+        // the panes paint their columns from x = 0, there are no tree controls to hide
+        m_hScroll->setRange(0, m_scrollGeometry.maxHScrollId());
+        m_hScroll->setValue(m_scrollGeometry.maxContentsX());
         m_hScroll->setSingleStep(10);
-        m_hScroll->setPageStep(minVisibleWidth() - 10);
+        // pressing shift and using a horizontal mouse wheel goes left and right one page at a time
+        m_hScroll->setPageStep(m_scrollGeometry.minVisibleWidth() - 10);
         m_hScroll->blockSignals(false);
     }
     else
@@ -213,7 +308,9 @@ void KompareSplitter::slotDelayedUpdateVScrollValue()
 
 void KompareSplitter::slotUpdateVScrollValue()
 {
-    m_vScroll->setValue(scrollId());
+    m_vScroll->blockSignals(true);
+    m_vScroll->setValue(vScrollValue(scrollId()));
+    m_vScroll->blockSignals(false);
 }
 
 void KompareSplitter::keyPressEvent(QKeyEvent* e)
@@ -230,21 +327,20 @@ void KompareSplitter::keyPressEvent(QKeyEvent* e)
         break;
     case Qt::Key_Up:
     case Qt::Key_K:
-        m_vScroll->triggerAction(QAbstractSlider::SliderSingleStepSub);
+        scrollVertically(-scrollDistance());
         break;
     case Qt::Key_Down:
     case Qt::Key_J:
-        m_vScroll->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+        scrollVertically(scrollDistance());
         break;
     case Qt::Key_PageDown:
-        m_vScroll->triggerAction(QAbstractSlider::SliderPageStepAdd);
+        scrollVertically(m_scrollGeometry.pageSize());
         break;
     case Qt::Key_PageUp:
-        m_vScroll->triggerAction(QAbstractSlider::SliderPageStepSub);
+        scrollVertically(-m_scrollGeometry.pageSize());
         break;
     }
     e->accept();
-    slotRepaintHandles();
 }
 
 void KompareSplitter::wheelEvent(QWheelEvent* e)
@@ -253,14 +349,14 @@ void KompareSplitter::wheelEvent(QWheelEvent* e)
     {
         if (e->modifiers() & Qt::ControlModifier) {
             if (e->angleDelta().y() < 0)   // scroll down one page
-                m_vScroll->triggerAction(QAbstractSlider::SliderPageStepAdd);
+                scrollVertically(m_scrollGeometry.pageSize());
             else // scroll up one page
-                m_vScroll->triggerAction(QAbstractSlider::SliderPageStepSub);
+                scrollVertically(-m_scrollGeometry.pageSize());
         } else {
             if (e->angleDelta().y() < 0)   // scroll down
-                m_vScroll->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+                scrollVertically(scrollDistance());
             else // scroll up
-                m_vScroll->triggerAction(QAbstractSlider::SliderSingleStepSub);
+                scrollVertically(-scrollDistance());
         }
     }
     else
@@ -278,18 +374,17 @@ void KompareSplitter::wheelEvent(QWheelEvent* e)
         }
     }
     e->accept();
-    slotDelayedRepaintHandles();
 }
 
 /* FIXME: this should return/the scrollId() from the listview containing the
  * /base/ of the diff. but there's bigger issues with that atm.
  */
 
-int KompareSplitter::scrollId()
+qint64 KompareSplitter::scrollId()
 {
     if (widget(0))
         return listView(0)->scrollId();
-    return minVScrollId();
+    return m_scrollGeometry.minVScrollId();
 }
 
 int KompareSplitter::lineHeight()
@@ -299,114 +394,9 @@ int KompareSplitter::lineHeight()
     return 1;
 }
 
-int KompareSplitter::pageSize()
-{
-    if (widget(0)) {
-        KompareListView* view = listView(0);
-        return view->visibleHeight() - view->style()->pixelMetric(QStyle::PM_ScrollBarExtent);
-    }
-    return 1;
-}
-
-bool KompareSplitter::needVScrollBar()
+int KompareSplitter::scrollDistance()
 {
-    int pagesize = pageSize();
-    const int end = count();
-    for (int i = 0; i < end; ++i) {
-        KompareListView* view = listView(i);
-        if (view ->contentsHeight() > pagesize)
-            return true;
-    }
-    return false;
-}
-
-int KompareSplitter::minVScrollId()
-{
-
-    int min = -1;
-    int mSId;
-    const int end = count();
-    for (int i = 0; i < end; ++i) {
-        mSId = listView(i)->minScrollId();
-        if (mSId < min || min == -1)
-            min = mSId;
-    }
-    return (min == -1) ? 0 : min;
-}
-
-int KompareSplitter::maxVScrollId()
-{
-    int max = 0;
-    int mSId;
-    const int end = count();
-    for (int i = 0; i < end; ++i) {
-        mSId = listView(i)->maxScrollId();
-        if (mSId > max)
-            max = mSId;
-    }
-    return max;
-}
-
-bool KompareSplitter::needHScrollBar()
-{
-    const int end = count();
-    for (int i = 0; i < end; ++i) {
-        KompareListView* view = listView(i);
-        if (view->contentsWidth() > view->visibleWidth())
-            return true;
-    }
-    return false;
-}
-
-int KompareSplitter::minHScrollId()
-{
-    // hardcode an offset to hide the tree controls
-    return 6;
-}
-
-int KompareSplitter::maxHScrollId()
-{
-    int max = 0;
-    int mHSId;
-    const int end = count();
-    for (int i = 0; i < end; ++i) {
-        KompareListView* view = listView(i);
-        mHSId = view->contentsWidth() - view->visibleWidth();
-        if (mHSId > max)
-            max = mHSId;
-    }
-    return max;
-}
-
-int KompareSplitter::maxContentsX()
-{
-    int max = 0;
-    int mCX;
-    const int end = count();
-    for (int i = 0; i < end; ++i) {
-        mCX = listView(i)->contentsX();
-        if (mCX > max)
-            max = mCX;
-    }
-    return max;
-}
-
-int KompareSplitter::minVisibleWidth()
-{
-    // Why the hell do we want to know this?
-    // ah yes, it is because we use it to set the "page size" for horiz. scrolling.
-    // despite the fact that *none* has a pgright and pgleft key :P
-    // But we do have mousewheels with horizontal scrolling functionality,
-    // pressing shift and scrolling then goes left and right one page at the time
-    int min = -1;
-    int vW;
-    const int end = count();
-    for (int i = 0; i < end; ++i) {
-        vW = listView(i)->visibleWidth();
-        if (vW < min || min == -1)
-            min = vW;
-    }
-    return (min == -1) ? 0 : min;
+    return m_settings->m_scrollNoOfLines * lineHeight();
 }
 
 KompareListView* KompareSplitter::listView(int index)
@@ -421,6 +411,8 @@ KompareConnectWidget* KompareSplitter::connectWidget(int index)
 
 void KompareSplitter::slotSetSelection(const DiffModel* model, const Difference* diff)
 {
+    m_highlighter.setModel(model);
+
     const int end = count();
     for (int i = 0; i < end; ++i) {
         connectWidget(i)->slotSetSelection(model, diff);
@@ -428,20 +420,38 @@ void KompareSplitter::slotSetSelection(const DiffModel* model, const Difference*
         static_cast<KompareListViewFrame*>(widget(i))->slotSetModel(model);
     }
 
+    if (model != m_overviewModel) {
+        m_overviewModel = model;
+        updateOverview();
+    }
+
     slotDelayedRepaintHandles();
     slotDelayedUpdateScrollBars();
 }
 
+void KompareSplitter::updateOverview()
+{
+    // the panes share the scroll id space, either one describes the whole model
+    if (widget(0))
+        m_overview->setEntries(listView(0)->overviewEntries(), listView(0)->scrollHeight());
+}
+
 void KompareSplitter::slotSetSelection(const Difference* diff)
 {
+    const qint64 id = scrollId();
+
+    // the panes and connectors repaint the two differences that changed themselves
     const int end = count();
     for (int i = 0; i < end; ++i) {
         connectWidget(i)->slotSetSelection(diff);
         listView(i)->slotSetSelection(diff);
     }
 
-    slotDelayedRepaintHandles();
-    slotDelayedUpdateScrollBars();
+    // everything moved when the selection was scrolled into view
+    if (scrollId() != id) {
+        slotDelayedRepaintHandles();
+        slotDelayedUpdateVScrollValue();
+    }
 }
 
 void KompareSplitter::slotApplyDifference(bool apply)
@@ -449,15 +459,22 @@ void KompareSplitter::slotApplyDifference(bool apply)
     const int end = count();
     for (int i = 0; i < end; ++i)
         listView(i)->slotApplyDifference(apply);
+    if (widget(0))
+        m_overview->slotDifferenceChanged(listView(0)->selectedDifference());
     slotDelayedRepaintHandles();
 }
 
 void KompareSplitter::slotApplyAllDifferences(bool apply)
 {
+    // Nothing is painted until every pane has been relaid out
+    setUpdatesEnabled(false);
     const int end = count();
     for (int i = 0; i < end; ++i)
         listView(i)->slotApplyAllDifferences(apply);
+    setUpdatesEnabled(true);
+    updateOverview();
     slotDelayedRepaintHandles();
+    slotDelayedUpdateScrollBars();
     slotScrollToId(m_scrollTo);   // FIXME!
 }
 
@@ -466,6 +483,7 @@ void KompareSplitter::slotApplyDifference(const Difference* diff, bool apply)
     const int end = count();
     for (int i = 0; i < end; ++i)
         listView(i)->slotApplyDifference(diff, apply);
+    m_overview->slotDifferenceChanged(diff);
     slotDelayedRepaintHandles();
 }
 
@@ -477,12 +495,24 @@ void KompareSplitter::slotDifferenceClicked(const Difference* diff)
     emit selectionChanged(diff);
 }
 
+void KompareSplitter::slotModelsChanged()
+{
+    m_highlighter.slotModelsChanged();
+
+    const int end = count();
+    for (int i = 0; i < end; ++i)
+        listView(i)->slotModelsChanged();
+    m_overviewModel = nullptr;
+    m_overview->setEntries(QVector<KompareOverviewEntry>(), 0);
+}
+
 void KompareSplitter::slotConfigChanged()
 {
     const int end = count();
     for (int i = 0; i < end; ++i) {
-        KompareListView* view = listView(i);
-        view->setFont(m_settings->m_font);
-        view->update();
+        listView(i)->slotConfigChanged();
     }
+    // new fonts move the differences, new colors repaint them
+    updateOverview();
+    m_highlighter.slotConfigChanged();
 }
@@ -18,10 +18,15 @@
 #ifndef _KOMPARESPLITTER_H_
 #define _KOMPARESPLITTER_H_
 
+#include <QElapsedTimer>
 #include <QSplitter>
+#include <QVector>
 
 #include <libkomparediff2/komparemodellist.h>
 
+#include "komparehighlighter.h"
+#include "komparescrollgeometry.h"
+
 class QSplitterHandle;
 class QTimer;
 class QScrollBar;
@@ -36,6 +41,7 @@ class ViewSettings;
 
 class KompareListView;
 class KompareConnectWidget;
+class KompareOverviewRuler;
 
 class KompareSplitter : public QSplitter
 {
@@ -45,16 +51,28 @@ public:
     KompareSplitter(ViewSettings* settings, QWidget* parent);
     ~KompareSplitter() override;
 
+    /** Number of frames per frame time bucket of up to 1, 2, 4 ... ms, the last bucket takes the rest */
+    const QVector<int>& frameTimeHistogram() const { return m_frameTimes; }
+
+    /** The panes publish their extents here */
+    KompareScrollGeometry* scrollGeometry() { return &m_scrollGeometry; }
+    /** Both panes show the lines it highlights */
+    KompareHighlighter* highlighter() { return &m_highlighter; }
+
+    /** Scrolls line of diff, in the source or the destination pane, to the middle of the view */
+    void scrollToLine(const Diff2::Difference* diff, bool source, int line);
+
 Q_SIGNALS:
     void configChanged();
 
-    void scrollViewsToId(int id);
+    void scrollViewsToId(qint64 id);
     void setXOffset(int x);
 
     void selectionChanged(const Diff2::Difference* diff);
 
 public Q_SLOTS:
-    void slotScrollToId(int id);
+    void slotScrollToId(qint64 id);
+    void slotScrollToX(int x);
     void slotDelayedUpdateScrollBars();
     void slotUpdateScrollBars();
     void slotDelayedUpdateVScrollValue();
@@ -71,6 +89,7 @@ public Q_SLOTS:
     void slotDifferenceClicked(const Diff2::Difference* diff);
 
     void slotConfigChanged();
+    void slotModelsChanged();
 
 protected:
     void wheelEvent(QWheelEvent* e) override;
@@ -80,7 +99,8 @@ protected:
 protected Q_SLOTS:
     void slotDelayedRepaintHandles();
     void slotRepaintHandles();
-    void timerTimeout();
+    void slotFrame();
+    void slotVScrollValueChanged(int value);
 
 private:
     // override from QSplitter
@@ -89,6 +109,14 @@ private:
     void               setCursor(int id, const QCursor& cursor);
     void               unsetCursor(int id);
 
+    int                vScrollValue(qint64 id) const;
+    void               scrollVertically(qint64 delta);
+
+    int                frameInterval();
+    void               scheduleFrame();
+    void               recordFrameTime(qint64 msecs);
+    void               updateOverview();
+
 protected:
     KompareListView* listView(int index);
     KompareConnectWidget* connectWidget(int index);
@@ -96,25 +124,29 @@ protected:
 private:
 
     // Scrollbars. all this just for the goddamn scrollbars. i hate them.
-    int  scrollId();
+    qint64 scrollId();
     int  lineHeight();
-    int  pageSize();
-    bool needVScrollBar();
-    int  minVScrollId();
-    int  maxVScrollId();
-    bool needHScrollBar();
-    int  minHScrollId();
-    int  maxHScrollId();
-    int  maxContentsX();
-    int  minVisibleWidth();
-
-    QTimer*            m_scrollTimer;
-    bool               m_restartTimer;
-    int                m_scrollTo;
+    int  scrollDistance();
+
+    KompareScrollGeometry m_scrollGeometry;
+
+    QTimer*            m_frameTimer;
+    QElapsedTimer      m_lastFrame;
+    qint64             m_scrollTo;
+    qint64             m_vScrollScale; // scroll ids per step of m_vScroll
+    int                m_xTo;
+    bool               m_scrollPending;
+    bool               m_xPending;
+    bool               m_repaintHandlesPending;
+    QVector<int>       m_frameTimes;
+    int                m_frameCount;
 
     ViewSettings*      m_settings;
     QScrollBar*        m_vScroll;
     QScrollBar*        m_hScroll;
+    KompareOverviewRuler* m_overview;
+    const Diff2::DiffModel* m_overviewModel;
+    KompareHighlighter m_highlighter;
 
     friend class KompareConnectWidgetFrame;
 };
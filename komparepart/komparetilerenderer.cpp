@@ -0,0 +1,84 @@
+/***************************************************************************
+                                komparetilerenderer.cpp
+                                -----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparetilerenderer.h"
+
+#include <QElapsedTimer>
+#include <QPainter>
+
+KompareRenderedTile renderTile(const KompareTileSnapshot& snapshot)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // opaque, so text gets the same antialiasing as on screen
+    QImage image(snapshot.size * snapshot.devicePixelRatio, QImage::Format_RGB32);
+    image.setDevicePixelRatio(snapshot.devicePixelRatio);
+    image.fill(snapshot.base);
+
+    QPainter p(&image);
+    p.translate(-snapshot.x, 0);
+    p.setFont(snapshot.font);
+    const int width = snapshot.size.width() + snapshot.x;
+
+    for (const KompareTileRow& row : snapshot.rows)
+    {
+        // Paint background
+        p.fillRect(0, row.y, width, row.height, row.background);
+        if (row.type != KompareTileRow::Hunk)
+            p.fillRect(0, row.y, snapshot.lineNumberWidth, row.height, row.lineNumberBackground);
+
+        // Paint foreground
+        p.setPen(row.foreground);
+        if (row.type == KompareTileRow::Hunk)
+            p.drawText(row.textRect, Qt::AlignLeft | Qt::AlignVCenter, row.text);
+        else if (row.type == KompareTileRow::Line)
+            p.drawText(row.textRect, Qt::AlignRight, row.text);
+
+        if (!row.runs.isEmpty())
+        {
+            QBrush changeBrush(row.background, Qt::Dense3Pattern);
+            for (const KompareTileRun& run : row.runs)
+            {
+                if (run.changed)
+                {
+                    p.setFont(snapshot.boldFont);
+                    p.fillRect(run.x, row.y, run.width, row.height, changeBrush);
+                }
+                else
+                {
+                    p.setFont(snapshot.font);
+                }
+                p.setPen(run.color.isValid() ? run.color : row.foreground);
+                p.drawText(run.x, row.y, run.width, row.height, Qt::AlignLeft | Qt::AlignVCenter, run.text);
+            }
+            p.setFont(snapshot.font);
+        }
+
+        // Paint darker lines around selected item
+        if (row.topBorder || row.bottomBorder)
+        {
+            p.setPen(row.background.darker(135));
+            if (row.topBorder)
+                p.drawLine(QLineF(0, row.y + 0.5, width, row.y + 0.5));
+            if (row.bottomBorder)
+                p.drawLine(QLineF(0, row.y + row.height - 0.5, width, row.y + row.height - 0.5));
+        }
+    }
+
+    p.end();
+    return { image, timer.nsecsElapsed() };
+}
@@ -0,0 +1,89 @@
+/***************************************************************************
+                                komparetilerenderer.h
+                                ---------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPARETILERENDERER_H
+#define KOMPARETILERENDERER_H
+
+#include <QColor>
+#include <QFont>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+/**
+ * A piece of a line, drawn bold on a patterned background when it is part of a change.
+ */
+struct KompareTileRun
+{
+    QString text;
+    int     x;
+    int     width;
+    bool    changed;
+    QColor  color;      // syntax highlighting, invalid for the foreground of the row
+};
+
+/**
+ * A hunk header, a line or the blank placeholder of a difference without lines.
+ */
+struct KompareTileRow
+{
+    enum Type { Hunk, Line, Blank };
+
+    Type                    type;
+    int                     y;          // top of the row in the tile
+    int                     height;
+    QColor                  background;
+    QColor                  lineNumberBackground;
+    QColor                  foreground;
+    QRect                   textRect;   // line number or hunk function
+    QString                 text;
+    QVector<KompareTileRun> runs;
+    bool                    topBorder;  // the lines around the selected difference
+    bool                    bottomBorder;
+};
+
+/**
+ * Everything needed to render one tile of a diff pane.
+ *
+ * It is built on the GUI thread from the model and holds no pointers into
+ * it, so the rendering can run on a worker thread.
+ */
+struct KompareTileSnapshot
+{
+    QSize                   size;
+    qreal                   devicePixelRatio;
+    int                     x;          // left of the tile in the contents
+    int                     lineNumberWidth;
+    QFont                   font;
+    QFont                   boldFont;
+    QColor                  base;       // below the last row
+    QVector<KompareTileRow> rows;
+};
+
+struct KompareRenderedTile
+{
+    QImage image;
+    qint64 renderTime;  // in nanoseconds
+};
+
+/**
+ * Renders a snapshot with the raster engine, safe to call from any thread.
+ */
+KompareRenderedTile renderTile(const KompareTileSnapshot& snapshot);
+
+#endif
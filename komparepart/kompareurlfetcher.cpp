@@ -0,0 +1,152 @@
+/***************************************************************************
+                                kompareurlfetcher.cpp
+                                ---------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "kompareurlfetcher.h"
+
+#include <QDir>
+#include <QTemporaryDir>
+
+#include <KIO/CopyJob>
+#include <KIO/FileCopyJob>
+#include <KIO/StatJob>
+#include <KJobWidgets>
+#include <KLocalizedString>
+
+#include <komparepartdebug.h>
+
+KompareUrlFetcher::KompareUrlFetcher(const QUrl& url, QWidget* window, QObject* parent) :
+    QObject(parent),
+    m_url(url),
+    m_window(window),
+    m_tmpDir(nullptr)
+{
+}
+
+KompareUrlFetcher::~KompareUrlFetcher()
+{
+    cancel();
+}
+
+void KompareUrlFetcher::start()
+{
+    KIO::StatJob* statJob = KIO::stat(m_url);
+    KJobWidgets::setWindow(statJob, m_window);
+    connect(statJob, &KJob::result, this, &KompareUrlFetcher::slotStatResult);
+    m_job = statJob;
+}
+
+void KompareUrlFetcher::cancel()
+{
+    if (m_job) {
+        m_job->kill();
+        m_job = nullptr;
+    }
+    delete m_tmpDir;
+    m_tmpDir = nullptr;
+    m_localPath.clear();
+}
+
+QTemporaryDir* KompareUrlFetcher::takeTemporaryDir()
+{
+    QTemporaryDir* tmpDir = m_tmpDir;
+    m_tmpDir = nullptr;
+    return tmpDir;
+}
+
+void KompareUrlFetcher::fail(KJob* job)
+{
+    // cancelling from the job tracker is not an error to report
+    if (job->error() != KJob::KilledJobError) {
+        qCDebug(KOMPAREPART) << "download error " << job->errorString();
+        m_errorString = i18n("<qt>The URL <b>%1</b> cannot be downloaded.</qt>", m_url.toDisplayString());
+    }
+    delete m_tmpDir;
+    m_tmpDir = nullptr;
+    m_localPath.clear();
+    emit finished(this);
+}
+
+void KompareUrlFetcher::slotStatResult(KJob* job)
+{
+    m_job = nullptr;
+    if (job->error()) {
+        fail(job);
+        return;
+    }
+
+    const KIO::UDSEntry node = static_cast<KIO::StatJob*>(job)->statResult();
+    m_tmpDir = new QTemporaryDir(QDir::tempPath() + QLatin1String("/kompare"));
+    m_tmpDir->setAutoRemove(true);   // Yes this is the default but just to make sure
+
+    if (!node.isDir())
+    {
+        m_localPath = m_tmpDir->path() + QLatin1Char('/') + m_url.fileName();
+        KIO::FileCopyJob* copyJob = KIO::file_copy(m_url, QUrl::fromLocalFile(m_localPath));
+        KJobWidgets::setWindow(copyJob, m_window);
+        connect(copyJob, &KJob::result, this, &KompareUrlFetcher::slotFileCopyResult);
+        m_job = copyJob;
+    }
+    else
+    {
+        KIO::CopyJob* copyJob = KIO::copy(m_url, QUrl::fromLocalFile(m_tmpDir->path()));
+        KJobWidgets::setWindow(copyJob, m_window);
+        connect(copyJob, &KJob::result, this, &KompareUrlFetcher::slotDirectoryCopyResult);
+        m_job = copyJob;
+    }
+}
+
+void KompareUrlFetcher::slotFileCopyResult(KJob* job)
+{
+    m_job = nullptr;
+    if (job->error()) {
+        fail(job);
+        return;
+    }
+
+    emit finished(this);
+}
+
+void KompareUrlFetcher::slotDirectoryCopyResult(KJob* job)
+{
+    m_job = nullptr;
+    if (job->error()) {
+        fail(job);
+        return;
+    }
+
+    m_localPath = m_tmpDir->path();
+    qCDebug(KOMPAREPART) << "tempFileName = " << m_localPath;
+    // If a directory is copied into QTemporaryDir then the directory in
+    // here is what I need to add to the path
+    QDir dir(m_localPath);
+    QStringList entries = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    if (entries.size() == 1)   // More than 1 entry in here means big problems!!!
+    {
+        if (!m_localPath.endsWith(QLatin1Char('/')))
+            m_localPath += QLatin1Char('/');
+        m_localPath += entries.at(0);
+        m_localPath += QLatin1Char('/');
+    }
+    else
+    {
+        qCDebug(KOMPAREPART) << "Yikes, nothing downloaded?";
+        delete m_tmpDir;
+        m_tmpDir = nullptr;
+        m_localPath.clear();
+    }
+
+    emit finished(this);
+}
@@ -0,0 +1,75 @@
+/***************************************************************************
+                                kompareurlfetcher.h
+                                -------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPAREURLFETCHER_H
+#define KOMPAREURLFETCHER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QUrl>
+
+class KJob;
+class QTemporaryDir;
+class QWidget;
+
+/**
+ * Downloads a remote file or directory into a temporary directory.
+ *
+ * The KIO jobs run without blocking, their progress is shown by the job
+ * tracker, which can also cancel them. finished() is emitted once, unless
+ * cancel() is called first.
+ */
+class KompareUrlFetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    KompareUrlFetcher(const QUrl& url, QWidget* window, QObject* parent);
+    ~KompareUrlFetcher() override;
+
+    void start();
+    /** Kills the running job, finished() is not emitted */
+    void cancel();
+
+    const QUrl& url() const { return m_url; }
+    /** Where the download is, empty when it failed */
+    const QString& localPath() const { return m_localPath; }
+    /** Empty when it succeeded or the user cancelled it */
+    const QString& errorString() const { return m_errorString; }
+    /** The caller owns the directory holding the download */
+    QTemporaryDir* takeTemporaryDir();
+
+Q_SIGNALS:
+    void finished(KompareUrlFetcher* fetcher);
+
+private Q_SLOTS:
+    void slotStatResult(KJob* job);
+    void slotFileCopyResult(KJob* job);
+    void slotDirectoryCopyResult(KJob* job);
+
+private:
+    void fail(KJob* job);
+
+    QUrl             m_url;
+    QWidget*         m_window;
+    QPointer<KJob>   m_job;
+    QTemporaryDir*   m_tmpDir;
+    QString          m_localPath;
+    QString          m_errorString;
+};
+
+#endif
@@ -0,0 +1,136 @@
+/***************************************************************************
+                                komparestdinreader.cpp
+                                ----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparestdinreader.h"
+
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTextCodec>
+#include <QTimer>
+
+#include <kompareshelldebug.h>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#define CHUNK_SIZE      65536
+#define UPDATE_INTERVAL 250
+
+KompareStdinReader::KompareStdinReader(QObject* parent) :
+    QObject(parent),
+    m_notifier(nullptr),
+    m_timer(new QTimer(this)),
+    m_decoder(QTextCodec::codecForLocale()->makeDecoder()),
+    m_scanned(0),
+    m_previousLine(0),
+    m_end(0),
+    m_sectionStarted(false)
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &KompareStdinReader::slotUpdate);
+}
+
+KompareStdinReader::~KompareStdinReader()
+{
+}
+
+void KompareStdinReader::start()
+{
+#ifdef Q_OS_UNIX
+    m_notifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &KompareStdinReader::slotReadyRead);
+#else
+    // stdin can not be watched here, so read all of it at once
+    QFile file;
+    file.open(stdin, QIODevice::ReadOnly);
+    m_buffer = file.readAll();
+    file.close();
+    QTimer::singleShot(0, this, &KompareStdinReader::finish);
+#endif
+}
+
+void KompareStdinReader::slotReadyRead()
+{
+#ifdef Q_OS_UNIX
+    char buffer[CHUNK_SIZE];
+    const ssize_t count = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (count < 0 && (errno == EINTR || errno == EAGAIN))
+        return;
+
+    if (count <= 0)
+    {
+        if (count < 0)
+            qCDebug(KOMPARESHELL) << "Reading stdin failed, errno " << errno;
+        finish();
+        return;
+    }
+
+    m_buffer.append(buffer, count);
+    scanLines();
+
+    if (!m_timer->isActive() && m_end > 0)
+        m_timer->start(UPDATE_INTERVAL);
+#endif
+}
+
+void KompareStdinReader::scanLines()
+{
+    for (int newline = m_buffer.indexOf('\n', m_scanned); newline >= 0; newline = m_buffer.indexOf('\n', m_scanned))
+    {
+        const KompareDiffScanner::Boundary boundary = m_scanner.addLine(m_buffer.constData() + m_scanned, newline - m_scanned);
+        if (boundary != KompareDiffScanner::NoBoundary)
+        {
+            // the first header only starts a section, it does not end one
+            if (m_sectionStarted)
+                m_end = boundary == KompareDiffScanner::AtLine ? m_scanned : m_previousLine;
+            m_sectionStarted = true;
+        }
+        m_previousLine = m_scanned;
+        m_scanned = newline + 1;
+    }
+}
+
+void KompareStdinReader::slotUpdate()
+{
+    if (m_end <= 0)
+        return;
+
+    // a section ends with a line feed, the decoder has nothing left over
+    const QString sections = m_decoder->toUnicode(m_buffer.constData(), m_end);
+    m_buffer.remove(0, m_end);
+    m_scanned -= m_end;
+    m_previousLine -= m_end;
+    m_end = 0;
+
+    qCDebug(KOMPARESHELL) << "Handing out " << sections.size() << " characters of stdin";
+    emit diffAvailable(sections);
+}
+
+void KompareStdinReader::finish()
+{
+    m_timer->stop();
+    delete m_notifier;
+    m_notifier = nullptr;
+
+    QString rest = m_decoder->toUnicode(m_buffer.constData(), m_buffer.size());
+    rest += m_decoder->toUnicode("", 0);
+    m_buffer.clear();
+
+    qCDebug(KOMPARESHELL) << "Read the last " << rest.size() << " characters from stdin";
+    emit finished(rest);
+}
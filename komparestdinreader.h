@@ -0,0 +1,78 @@
+/***************************************************************************
+                                komparestdinreader.h
+                                --------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPARESTDINREADER_H
+#define KOMPARESTDINREADER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+
+#include "komparepart/komparediffscanner.h"
+
+class QSocketNotifier;
+class QTextDecoder;
+class QTimer;
+
+/**
+ * Reads a diff from stdin while the producer is still writing it.
+ *
+ * The raw bytes are scanned for file headers a line at a time, the same
+ * way a diff file is indexed. Once a new file section begins, the ones
+ * before it are complete: they are decoded, handed out with diffAvailable()
+ * and dropped, so the part can add them to the files that are shown. Only
+ * the section that is still being read is kept.
+ */
+class KompareStdinReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KompareStdinReader(QObject* parent);
+    ~KompareStdinReader() override;
+
+    void start();
+
+Q_SIGNALS:
+    /** File sections that are complete, each one is handed out once */
+    void diffAvailable(const QString& sections);
+    /** All of stdin has been read, rest is what was not handed out before */
+    void finished(const QString& rest);
+
+private Q_SLOTS:
+    void slotReadyRead();
+    void slotUpdate();
+
+private:
+    void scanLines();
+    void finish();
+
+    QSocketNotifier*              m_notifier;
+    QTimer*                       m_timer;
+    QScopedPointer<QTextDecoder>  m_decoder;
+    KompareDiffScanner            m_scanner;
+    // what was read and not handed out yet
+    QByteArray                    m_buffer;
+    // where the line that is scanned next begins, and the one before it
+    int                           m_scanned;
+    int                           m_previousLine;
+    // where the section that is being read begins, 0 before the first one
+    int                           m_end;
+    bool                          m_sectionStarted;
+};
+
+#endif
@@ -26,10 +26,9 @@
 #include <KUrlComboBox>
 #include <KUrlRequester>
 
-#include <libkomparediff2/diffsettings.h>
-
 #include <kompareshelldebug.h>
 #include "diffpage.h"
+#include "komparediffsettings.h"
 #include "filespage.h"
 #include "filessettings.h"
 #include "viewpage.h"
@@ -54,7 +53,7 @@ KompareURLDialog::KompareURLDialog(QWidget* parent)
     KPageWidgetItem* diffItem = addPage(m_diffPage, i18n("Diff"));
     diffItem->setIcon(QIcon::fromTheme(QStringLiteral("text-x-patch")));
     diffItem->setHeader(i18n("Here you can change the options for comparing the files."));
-    m_diffSettings = new DiffSettings(this);
+    m_diffSettings = new KompareDiffSettings(this);
     m_diffSettings->loadSettings(cfg.data());
     m_diffPage->setSettings(m_diffSettings);
 
@@ -23,7 +23,7 @@
 class FilesPage;
 class FilesSettings;
 class DiffPage;
-class DiffSettings;
+class KompareDiffSettings;
 class ViewPage;
 class ViewSettings;
 
@@ -64,7 +64,7 @@ private:
     FilesPage*     m_filesPage;
     FilesSettings* m_filesSettings;
     DiffPage*      m_diffPage;
-    DiffSettings*  m_diffSettings;
+    KompareDiffSettings* m_diffSettings;
     ViewPage*      m_viewPage;
     ViewSettings*  m_viewSettings;
 };
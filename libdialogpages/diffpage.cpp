@@ -41,7 +41,7 @@
 
 #include <kregexpeditorinterface.h>
 
-#include <libkomparediff2/diffsettings.h>
+#include "komparediffsettings.h"
 
 DiffPage::DiffPage() : QFrame(), m_ignoreRegExpDialog(nullptr)
 {
@@ -63,11 +63,12 @@ DiffPage::~DiffPage()
     m_settings = nullptr;
 }
 
-void DiffPage::setSettings(DiffSettings* setts)
+void DiffPage::setSettings(KompareDiffSettings* setts)
 {
     m_settings = setts;
 
     m_diffURLRequester->setText(m_settings->m_diffProgram);
+    m_builtInDiffCheckBox->setChecked(m_settings->m_builtInDiff);
 
     m_newFilesCheckBox->setChecked(m_settings->m_newFiles);
     m_smallerCheckBox->setChecked(m_settings->m_createSmallerDiff);
@@ -97,7 +98,7 @@ void DiffPage::setSettings(DiffSettings* setts)
     m_excludeFileURLComboBox->setUrl(QUrl::fromUserInput(m_settings->m_excludeFilesFileURL, QDir::currentPath(), QUrl::AssumeLocalFile));
 }
 
-DiffSettings* DiffPage::settings()
+KompareDiffSettings* DiffPage::settings()
 {
     return m_settings;
 }
@@ -110,6 +111,7 @@ void DiffPage::restore()
 void DiffPage::apply()
 {
     m_settings->m_diffProgram                    = m_diffURLRequester->text();
+    m_settings->m_builtInDiff                    = m_builtInDiffCheckBox->isChecked();
 
     m_settings->m_newFiles                       = m_newFilesCheckBox->isChecked();
     m_settings->m_largeFiles                     = m_largerCheckBox->isChecked();
@@ -142,6 +144,7 @@ void DiffPage::apply()
 void DiffPage::setDefaults()
 {
     m_diffURLRequester->setText(QString());
+    m_builtInDiffCheckBox->setChecked(true);
     m_newFilesCheckBox->setChecked(true);
     m_smallerCheckBox->setChecked(true);
     m_largerCheckBox->setChecked(true);
@@ -210,6 +213,10 @@ void DiffPage::addDiffTab()
     m_diffURLRequester->setPlaceholderText(QStringLiteral("diff"));
     bgLayout->addWidget(m_diffURLRequester);
 
+    m_builtInDiffCheckBox = new QCheckBox(i18n("Compare files without running the diff program"), m_diffProgramGroup);
+    m_builtInDiffCheckBox->setWhatsThis(i18n("Two files are compared by Kompare itself instead of starting the diff program. Folders are always compared by the diff program, and so are files when a different diff program is selected, when function names are shown or when the output format is not unified. Unless it is told to look for smaller changes Kompare stops looking for the smallest changes between very different files, optimizing for large files makes no difference to it. Turn this off to compare files with the diff program as well."));
+    bgLayout->addWidget(m_builtInDiffCheckBox);
+
     layout->addStretch(1);
 
     m_tabWidget->addTab(page, i18n("Diff"));
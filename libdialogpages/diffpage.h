@@ -36,7 +36,7 @@ class KEditListWidget;
 class KUrlComboBox;
 class KUrlRequester;
 
-class DiffSettings;
+class KompareDiffSettings;
 
 class DIALOGPAGES_EXPORT DiffPage : public QFrame
 {
@@ -46,8 +46,8 @@ public:
     ~DiffPage() override;
 
 public:
-    void setSettings(DiffSettings*);
-    DiffSettings* settings();
+    void setSettings(KompareDiffSettings*);
+    KompareDiffSettings* settings();
 
 public:
     virtual void restore();
@@ -66,9 +66,10 @@ private:
     void addExcludeTab();
 
 public:
-    DiffSettings*  m_settings;
+    KompareDiffSettings* m_settings;
 
     KUrlRequester* m_diffURLRequester;
+    QCheckBox*     m_builtInDiffCheckBox;
 
     QCheckBox*     m_newFilesCheckBox;
     QCheckBox*     m_smallerCheckBox;
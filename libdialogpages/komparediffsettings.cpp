@@ -0,0 +1,47 @@
+/***************************************************************************
+                                komparediffsettings.cpp
+                                -----------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#include "komparediffsettings.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+
+KompareDiffSettings::KompareDiffSettings(QWidget* parent)
+    : DiffSettings(parent),
+      m_builtInDiff(true)
+{
+}
+
+KompareDiffSettings::~KompareDiffSettings()
+{
+}
+
+void KompareDiffSettings::loadSettings(KConfig* config)
+{
+    DiffSettings::loadSettings(config);
+
+    KConfigGroup group(config, "Diff Options");
+    m_builtInDiff = group.readEntry("BuiltInDiff", true);
+}
+
+void KompareDiffSettings::saveSettings(KConfig* config)
+{
+    // the base class syncs the config
+    KConfigGroup group(config, "Diff Options");
+    group.writeEntry("BuiltInDiff", m_builtInDiff);
+
+    DiffSettings::saveSettings(config);
+}
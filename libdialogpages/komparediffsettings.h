@@ -0,0 +1,46 @@
+/***************************************************************************
+                                komparediffsettings.h
+                                ---------------------
+        begin                   : Sat Oct 17 2026
+        Copyright 2026 agent <agent@local>
+****************************************************************************/
+
+/***************************************************************************
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+***************************************************************************/
+
+#ifndef KOMPAREDIFFSETTINGS_H
+#define KOMPAREDIFFSETTINGS_H
+
+#include <libkomparediff2/diffsettings.h>
+
+#include "dialogpages_export.h"
+
+class KConfig;
+
+/**
+ * The diff settings of libkomparediff2 with those only Kompare knows about.
+ */
+class DIALOGPAGES_EXPORT KompareDiffSettings : public DiffSettings
+{
+    Q_OBJECT
+public:
+    explicit KompareDiffSettings(QWidget* parent);
+    ~KompareDiffSettings() override;
+
+public:
+    // some virtual functions that will be overloaded from the base class
+    void loadSettings(KConfig* config) override;
+    void saveSettings(KConfig* config) override;
+
+public:
+    // compare two files without running the diff program
+    bool m_builtInDiff;
+};
+
+#endif // KOMPAREDIFFSETTINGS_H
@@ -41,6 +41,7 @@ ViewPage::ViewPage() : QFrame()
     QGroupBox*   colorGroupBox;
     QGroupBox*   snolGroupBox;
     QGroupBox*   tabGroupBox;
+    QGroupBox*   syntaxGroupBox;
 
     m_tabWidget = new QTabWidget(this);
     layout = new QVBoxLayout(this);
@@ -92,6 +93,14 @@ ViewPage::ViewPage() : QFrame()
     m_tabSpinBox->setRange(1, 16);
     tabLayout->addRow(i18n("Number of spaces to convert a tab character to:"), m_tabSpinBox);
 
+    syntaxGroupBox = new QGroupBox(page);
+    syntaxGroupBox->setTitle(i18n("Syntax Highlighting"));
+    layout->addWidget(syntaxGroupBox);
+    QVBoxLayout* syntaxLayout = new QVBoxLayout(syntaxGroupBox);
+
+    m_syntaxHighlightingCheckBox = new QCheckBox(i18n("Highlight the syntax of known file types"), syntaxGroupBox);
+    syntaxLayout->addWidget(m_syntaxHighlightingCheckBox);
+
     layout->addStretch(1);
 
     m_tabWidget->addTab(page, i18n("Appearance"));
@@ -132,6 +141,7 @@ void ViewPage::setSettings(ViewSettings* setts)
     m_appliedColorButton->setColor(m_settings->m_appliedColor);
     m_snolSpinBox->setValue(m_settings->m_scrollNoOfLines);
     m_tabSpinBox->setValue(m_settings->m_tabToNumberOfSpaces);
+    m_syntaxHighlightingCheckBox->setChecked(m_settings->m_syntaxHighlighting);
 
     m_fontCombo->setCurrentFont(m_settings->m_font.family());
     m_fontSizeSpinBox->setValue(m_settings->m_font.pointSize());
@@ -154,6 +164,7 @@ void ViewPage::apply()
     m_settings->m_appliedColor        = m_appliedColorButton->color();
     m_settings->m_scrollNoOfLines     = m_snolSpinBox->value();
     m_settings->m_tabToNumberOfSpaces = m_tabSpinBox->value();
+    m_settings->m_syntaxHighlighting  = m_syntaxHighlightingCheckBox->isChecked();
 
     m_settings->m_font                = QFont(m_fontCombo->currentFont());
     m_settings->m_font.setPointSize(m_fontSizeSpinBox->value());
@@ -169,6 +180,7 @@ void ViewPage::setDefaults()
     m_appliedColorButton->setColor(ViewSettings::default_appliedColor);
     m_snolSpinBox->setValue(3);
     m_tabSpinBox->setValue(4);
+    m_syntaxHighlightingCheckBox->setChecked(true);
 
     // TODO: port
     // m_fontCombo->setCurrentFont   ( KGlobalSettings::fixedFont().family() );
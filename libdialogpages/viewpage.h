@@ -23,6 +23,7 @@
 
 #include "dialogpages_export.h"
 
+class QCheckBox;
 class QFontComboBox;
 class QSpinBox;
 class QTabWidget;
@@ -58,6 +59,7 @@ public:
     // snol == scroll number of lines
     QSpinBox*     m_snolSpinBox;
     QSpinBox*     m_tabSpinBox;
+    QCheckBox*    m_syntaxHighlightingCheckBox;
     QFontComboBox*   m_fontCombo;
     QSpinBox*     m_fontSizeSpinBox;
     QTabWidget*   m_tabWidget;
@@ -38,7 +38,8 @@ ViewSettings::ViewSettings(QWidget* parent)
       m_addColor(0, 0, 0),
       m_appliedColor(0, 0, 0),
       m_scrollNoOfLines(0),
-      m_tabToNumberOfSpaces(0)
+      m_tabToNumberOfSpaces(0),
+      m_syntaxHighlighting(true)
 {
 }
 
@@ -55,6 +56,7 @@ void ViewSettings::loadSettings(KConfig* config)
     m_appliedColor        = cfg.readEntry("AppliedColor",        default_appliedColor);
     m_scrollNoOfLines     = cfg.readEntry("ScrollNoOfLines",     3);
     m_tabToNumberOfSpaces = cfg.readEntry("TabToNumberOfSpaces", 4);
+    m_syntaxHighlighting  = cfg.readEntry("SyntaxHighlighting",  true);
 
     QFont stdFixed = QFontDatabase::systemFont(QFontDatabase::FixedFont);
     stdFixed.setPointSize(10);
@@ -70,6 +72,7 @@ void ViewSettings::saveSettings(KConfig* config)
     cfg.writeEntry("AppliedColor",        m_appliedColor);
     cfg.writeEntry("ScrollNoOfLines",     m_scrollNoOfLines);
     cfg.writeEntry("TabToNumberOfSpaces", m_tabToNumberOfSpaces);
+    cfg.writeEntry("SyntaxHighlighting",  m_syntaxHighlighting);
 
     cfg.writeEntry("TextFont",            m_font);
 }
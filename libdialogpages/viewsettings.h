@@ -54,6 +54,7 @@ public:
     QColor m_selectedAppliedColor;
     int    m_scrollNoOfLines;
     int    m_tabToNumberOfSpaces;
+    bool   m_syntaxHighlighting;
 
     QFont  m_font;
 };